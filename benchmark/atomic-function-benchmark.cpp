@@ -0,0 +1,135 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+// Measures the invocation throughput of a callback which is read by
+// 1 to N threads while a writer thread replaces it every millisecond,
+// compared to a function which is guarded by a reader writer lock.
+//
+// Usage: function2_atomic_function_benchmark [invocations per reader]
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "function2/atomic_function.hpp"
+
+#if __cplusplus >= 201402L
+  #include <shared_mutex>
+#endif
+
+namespace {
+#if __cplusplus >= 201402L
+  using shared_mutex_t = std::shared_timed_mutex;
+  using shared_lock_t = std::shared_lock<shared_mutex_t>;
+#else
+  using shared_mutex_t = std::mutex;
+  using shared_lock_t = std::lock_guard<shared_mutex_t>;
+#endif
+
+  /// A function which is guarded by a reader writer lock
+  class locked_function {
+    mutable shared_mutex_t mutex_;
+    fu2::function<int(int) const> function_;
+
+  public:
+    template<typename T>
+    explicit locked_function(T&& function)
+      : function_(std::forward<T>(function)) { }
+
+    template<typename T>
+    void store(T&& function) {
+      fu2::function<int(int) const> next(std::forward<T>(function));
+      std::lock_guard<shared_mutex_t> const lock(mutex_);
+      function_.swap(next);
+    }
+
+    int operator() (int value) const {
+      shared_lock_t const lock(mutex_);
+      return function_(value);
+    }
+  };
+
+  /// Returns the invocations per second of all readers together
+  template<typename Function>
+  double run(Function& function, unsigned readers, std::size_t invocations)
+  {
+    std::atomic<unsigned> ready(0U);
+    std::atomic<bool> is_done(false);
+
+    std::thread writer([&] {
+      int offset = 0;
+      while (!is_done.load()) {
+        ++offset;
+        function.store([offset](int value) { return value + offset; });
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    });
+
+    std::vector<std::thread> threads;
+    std::atomic<long long> sink(0);
+    for (unsigned i = 0; i < readers; ++i) {
+      threads.emplace_back([&] {
+        ready.fetch_add(1U);
+        while (ready.load() != readers) { }
+
+        long long result = 0;
+        for (std::size_t j = 0; j < invocations; ++j) {
+          result += function(static_cast<int>(j));
+        }
+        sink.fetch_add(result);
+      });
+    }
+
+    auto const begin = std::chrono::steady_clock::now();
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    auto const end = std::chrono::steady_clock::now();
+
+    is_done.store(true);
+    writer.join();
+
+    double const seconds = std::chrono::duration<double>(end - begin).count();
+    return static_cast<double>(invocations) * readers / seconds;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  std::size_t const invocations =
+    (argc > 1) ? std::stoul(argv[1]) : 5000000UL;
+  unsigned const cores = std::thread::hardware_concurrency();
+  unsigned const max_readers = cores ? cores : 1U;
+
+  std::cout << "Benchmark: Invoke a callback from 1 to " << max_readers
+            << " reader threads (" << invocations
+            << " invocations each) while it is replaced every 1ms"
+            << std::endl;
+
+  for (unsigned readers = 1U; readers <= max_readers; readers *= 2U) {
+    fu2::atomic_function<int(int)> atomic([](int value) { return value; });
+    locked_function locked([](int value) { return value; });
+
+    double const atomic_rate = run(atomic, readers, invocations);
+    double const locked_rate = run(locked, readers, invocations);
+
+    std::cout << "    " << readers << " readers:" << std::endl
+              << "        fu2::atomic_function:  "
+              << static_cast<long long>(atomic_rate / 1000000.0)
+              << "M calls/s" << std::endl
+              << "        shared lock function:  "
+              << static_cast<long long>(locked_rate / 1000000.0)
+              << "M calls/s" << std::endl;
+
+    if ((readers < max_readers) && (readers * 2U > max_readers))
+      readers = max_readers / 2U;
+  }
+  return EXIT_SUCCESS;
+}
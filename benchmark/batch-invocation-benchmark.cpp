@@ -0,0 +1,90 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+// Measures the throughput of a float(float) transform stage applied to
+// an array through one call per element, through a single batched call,
+// and through a loop around the concrete lambda which isn't type erased.
+//
+// Usage: function2_batch_invocation_benchmark [elements] [repetitions]
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "function2/function2.hpp"
+
+namespace {
+  using transform_t = fu2::function<float(float) const>;
+
+  /// Returns the elements per second of the given transform of the input
+  template<typename Transform>
+  double run(Transform&& transform, std::vector<float> const& input,
+             std::vector<float>& output, std::size_t repetitions) {
+    auto const begin = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < repetitions; ++i) {
+      transform(input, output);
+    }
+    auto const end = std::chrono::steady_clock::now();
+
+    double const seconds = std::chrono::duration<double>(end - begin).count();
+    return static_cast<double>(input.size()) * repetitions / seconds;
+  }
+
+  void report(char const* name, double rate) {
+    std::cout << "    " << name
+              << static_cast<long long>(rate / 1000000.0)
+              << "M elements/s" << std::endl;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  std::size_t const elements =
+    (argc > 1) ? std::stoul(argv[1]) : 1000000UL;
+  std::size_t const repetitions =
+    (argc > 2) ? std::stoul(argv[2]) : 100UL;
+
+  std::cout << "Benchmark: Apply a float(float) gain stage to "
+            << elements << " elements (" << repetitions
+            << " repetitions)" << std::endl;
+
+  std::vector<float> input(elements);
+  for (std::size_t i = 0; i < elements; ++i) {
+    input[i] = static_cast<float>(i % 1024) * 0.5f;
+  }
+  std::vector<float> output(elements);
+
+  float const factor = (argc > 3) ? std::stof(argv[3]) : 1.5f;
+  auto const gain = [factor](float value) { return value * factor + 1.f; };
+  transform_t const stage = gain;
+
+  double const per_element_rate = run(
+    [&](std::vector<float> const& in, std::vector<float>& out) {
+      for (std::size_t i = 0; i < in.size(); ++i) {
+        out[i] = stage(in[i]);
+      }
+    }, input, output, repetitions);
+
+  double const batched_rate = run(
+    [&](std::vector<float> const& in, std::vector<float>& out) {
+      stage.invoke_batch(in.data(), in.data() + in.size(), out.data());
+    }, input, output, repetitions);
+
+  double const direct_rate = run(
+    [&](std::vector<float> const& in, std::vector<float>& out) {
+      for (std::size_t i = 0; i < in.size(); ++i) {
+        out[i] = gain(in[i]);
+      }
+    }, input, output, repetitions);
+
+  report("fu2::function per element:  ", per_element_rate);
+  report("fu2::function invoke_batch: ", batched_rate);
+  report("lambda (not type erased):   ", direct_rate);
+
+  // Prevents the transformation from being optimized out
+  return (output[elements / 2] == 0.f) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
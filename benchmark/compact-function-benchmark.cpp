@@ -0,0 +1,138 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+// Measures the memory which is required to store 10M handlers,
+// like per connection callbacks, and the time to invoke all of them.
+// Every fourth handler is a small capture, a larger capture,
+// a function pointer or empty.
+//
+// Every wrapper is measured inside its own process, since freed memory
+// stays resident. The resident memory is measured on Linux only,
+// the size of the wrappers is reported on all platforms.
+//
+// Usage: function2_compact_function_benchmark [handlers] [wrapper index]
+
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "function2/function2.hpp"
+
+#ifdef __linux__
+  #include <unistd.h>
+#endif
+
+namespace {
+  long long counter = 0;
+
+  void increment() {
+    ++counter;
+  }
+
+  /// Returns the resident memory of the process in bytes,
+  /// or 0 when it isn't measurable.
+  std::size_t resident_memory() {
+#ifdef __linux__
+    std::ifstream statm("/proc/self/statm");
+    std::size_t pages = 0;
+    std::size_t resident = 0;
+    if (statm >> pages >> resident)
+      return resident * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#endif
+    return 0;
+  }
+
+  template<typename Function>
+  void run(char const* name, std::size_t handlers) {
+    std::size_t const before = resident_memory();
+    auto const begin = std::chrono::steady_clock::now();
+    {
+      std::vector<Function> stored;
+      stored.reserve(handlers);
+
+      std::array<long long, 3> large{{1, 2, 3}};
+      for (std::size_t i = 0; i < handlers; ++i) {
+        switch (i % 4) {
+          case 0:
+            stored.emplace_back([i] { counter += static_cast<long long>(i); });
+            break;
+          case 1:
+            stored.emplace_back([large] { counter += large[2]; });
+            break;
+          case 2:
+            stored.emplace_back(increment);
+            break;
+          default:
+            stored.emplace_back(nullptr);
+            break;
+        }
+      }
+      auto const stored_end = std::chrono::steady_clock::now();
+      std::size_t const after = resident_memory();
+
+      for (auto& handler : stored) {
+        if (handler)
+          handler();
+      }
+      auto const invoked_end = std::chrono::steady_clock::now();
+
+      std::cout << "    " << name << " (" << sizeof(Function)
+                << " bytes):" << std::endl
+                << "        resident memory:  ";
+      if (after)
+        std::cout << ((after - before) >> 20) << " MiB" << std::endl;
+      else
+        std::cout << "n/a" << std::endl;
+      std::cout << "        store:            "
+                << std::chrono::duration_cast<std::chrono::milliseconds>(
+                     stored_end - begin).count() << " ms" << std::endl
+                << "        invoke all:       "
+                << std::chrono::duration_cast<std::chrono::milliseconds>(
+                     invoked_end - stored_end).count() << " ms" << std::endl;
+    }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  std::size_t const handlers =
+    (argc > 1) ? std::stoul(argv[1]) : 10000000UL;
+
+  if (argc > 2) {
+    switch (std::stoul(argv[2])) {
+      case 0:
+        run<fu2::compact_unique_function<void()>>(
+          "fu2::compact_unique_function", handlers);
+        break;
+      case 1:
+        run<fu2::unique_function<void()>>("fu2::unique_function", handlers);
+        break;
+      case 2:
+        run<fu2::function_base<void(), false, 0UL>>(
+          "fu2::unique_function without capacity", handlers);
+        break;
+      default:
+        run<std::function<void()>>("std::function", handlers);
+        break;
+    }
+    return counter ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
+  std::cout << "Benchmark: Store and invoke " << handlers
+            << " handlers" << std::endl;
+
+  for (int wrapper = 0; wrapper < 4; ++wrapper) {
+    std::string const command = std::string("\"") + argv[0] + "\" " +
+      std::to_string(handlers) + " " + std::to_string(wrapper);
+    if (std::system(command.c_str()) != 0)
+      return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,160 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+// Generates N translation units which are using M signatures each,
+// and measures the time and the object size which is required to compile
+// them with implicit instantiation and with extern templates.
+//
+// Usage: function2_compile_benchmark [translation units] [signatures]
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace {
+  std::string const work_dir = FU2_BENCHMARK_WORK_DIR;
+
+  std::string path_of(std::string const& name)
+  {
+    return work_dir + "/" + name;
+  }
+
+  void write_file(std::string const& name, std::string const& content)
+  {
+    std::ofstream(path_of(name)) << content;
+  }
+
+  std::size_t size_of_file(std::string const& name)
+  {
+    std::ifstream file(path_of(name), std::ios::binary | std::ios::ate);
+    return file ? static_cast<std::size_t>(file.tellg()) : 0UL;
+  }
+
+  std::string signature_of(std::size_t index)
+  {
+    std::ostringstream out;
+    out << "int(tag<" << index << ">, int)";
+    return out.str();
+  }
+
+  /// The header which is shared between all translation units
+  std::string generate_header(std::size_t signatures)
+  {
+    std::ostringstream out;
+    out << "#include \"function2/function2.hpp\"\n"
+        << "template<int> struct tag { };\n"
+        << "#ifdef FU2_BENCHMARK_EXTERN\n";
+    for (std::size_t i = 0; i < signatures; ++i) {
+      out << "FU2_EXTERN_TEMPLATE_FUNCTION(" << signature_of(i) << ")\n"
+          << "FU2_EXTERN_TEMPLATE_UNIQUE_FUNCTION(" << signature_of(i) << ")\n";
+    }
+    out << "#endif\n";
+    return out.str();
+  }
+
+  /// The translation unit which holds all explicit instantiations
+  std::string generate_instantiations(std::size_t signatures)
+  {
+    std::ostringstream out;
+    out << "#include \"signatures.hpp\"\n";
+    for (std::size_t i = 0; i < signatures; ++i) {
+      out << "FU2_INSTANTIATE_FUNCTION(" << signature_of(i) << ")\n"
+          << "FU2_INSTANTIATE_UNIQUE_FUNCTION(" << signature_of(i) << ")\n";
+    }
+    return out.str();
+  }
+
+  /// A translation unit which constructs, copies, moves
+  /// and invokes every signature.
+  std::string generate_unit(std::size_t unit, std::size_t signatures)
+  {
+    std::ostringstream out;
+    out << "#include \"signatures.hpp\"\n";
+    for (std::size_t i = 0; i < signatures; ++i) {
+      out << "int use_" << unit << "_" << i << "(int value) {\n"
+          << "  fu2::function<" << signature_of(i) << "> fn =\n"
+          << "    [value](tag<" << i << ">, int arg) { return value + arg; };\n"
+          << "  auto copy = fn;\n"
+          << "  fu2::unique_function<" << signature_of(i) << "> moved =\n"
+          << "    std::move(copy);\n"
+          << "  return fn(tag<" << i << ">{}, 1) + moved(tag<" << i
+          << ">{}, 2);\n"
+          << "}\n";
+    }
+    return out.str();
+  }
+
+  /// Compiles the given source and returns whether the compilation succeeded
+  bool compile(std::string const& name, std::string const& definitions)
+  {
+    std::string const command = std::string(FU2_BENCHMARK_CXX_COMPILER) +
+      " -std=c++11 -O2 -c " + definitions +
+      " -I\"" + FU2_BENCHMARK_INCLUDE_DIR + "\"" +
+      " -I\"" + work_dir + "\"" +
+      " \"" + path_of(name + ".cpp") + "\"" +
+      " -o \"" + path_of(name + ".o") + "\"";
+    return std::system(command.c_str()) == 0;
+  }
+
+  struct result {
+    std::chrono::milliseconds duration;
+    std::size_t object_size;
+  };
+
+  bool run(std::size_t units, bool is_extern, result& out)
+  {
+    std::string const definitions = is_extern ? "-DFU2_BENCHMARK_EXTERN" : "";
+
+    auto const begin = std::chrono::steady_clock::now();
+    out.object_size = 0UL;
+
+    if (is_extern) {
+      if (!compile("instantiations", definitions))
+        return false;
+      out.object_size += size_of_file("instantiations.o");
+    }
+
+    for (std::size_t unit = 0; unit < units; ++unit) {
+      std::string const name = "unit_" + std::to_string(unit);
+      if (!compile(name, definitions))
+        return false;
+      out.object_size += size_of_file(name + ".o");
+    }
+
+    out.duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - begin);
+    return true;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  std::size_t const units = (argc > 1) ? std::stoul(argv[1]) : 16UL;
+  std::size_t const signatures = (argc > 2) ? std::stoul(argv[2]) : 32UL;
+
+  write_file("signatures.hpp", generate_header(signatures));
+  write_file("instantiations.cpp", generate_instantiations(signatures));
+  for (std::size_t unit = 0; unit < units; ++unit)
+    write_file("unit_" + std::to_string(unit) + ".cpp",
+               generate_unit(unit, signatures));
+
+  result implicit, external;
+  if (!run(units, false, implicit) || !run(units, true, external)) {
+    std::cerr << "Compilation failed!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Benchmark: Compile " << units << " translation units with "
+            << signatures << " signatures each" << std::endl
+            << "    implicit instantiation: " << implicit.duration.count()
+            << "ms, " << implicit.object_size << " bytes" << std::endl
+            << "    extern template:        " << external.duration.count()
+            << "ms, " << external.object_size << " bytes" << std::endl;
+  return EXIT_SUCCESS;
+}
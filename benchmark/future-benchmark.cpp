@@ -0,0 +1,109 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+// Measures creating a promise and future pair, fulfilling it and
+// consuming its value through fu2::promise compared to std::promise,
+// on a single thread and with the promises fulfilled by another thread.
+//
+// Usage: function2_future_benchmark [pairs]
+
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "function2/future.hpp"
+
+namespace {
+  using clock_type = std::chrono::steady_clock;
+
+  /// Returns the nanoseconds per operation of the given action
+  template<typename Action>
+  double measure(std::size_t operations, Action&& action) {
+    auto const begin = clock_type::now();
+    action();
+    auto const end = clock_type::now();
+    return std::chrono::duration<double, std::nano>(end - begin).count() /
+           static_cast<double>(operations ? operations : 1UL);
+  }
+
+  /// Fulfills and waits for every pair on the same thread
+  template<template<typename> class Promise>
+  double wait_local(std::size_t count, std::size_t& sum) {
+    return measure(count, [&] {
+      for (std::size_t i = 0UL; i < count; ++i) {
+        Promise<std::size_t> promise;
+        auto future = promise.get_future();
+        promise.set_value(i);
+        sum += future.get();
+      }
+    });
+  }
+
+  /// Attaches a continuation to every pair before fulfilling it
+  double continue_local(std::size_t count, std::size_t& sum) {
+    return measure(count, [&] {
+      for (std::size_t i = 0UL; i < count; ++i) {
+        fu2::promise<std::size_t> promise;
+        promise.get_future().subscribe([&sum](std::size_t value) {
+          sum += value;
+        });
+        promise.set_value(i);
+      }
+    });
+  }
+
+  /// Fulfills all pairs on another thread while waiting for them in order
+  template<template<typename> class Promise>
+  double wait_remote(std::size_t count, std::size_t& sum) {
+    std::vector<Promise<std::size_t>> promises(count);
+    using future_t = decltype(promises.front().get_future());
+    std::vector<future_t> futures;
+    futures.reserve(count);
+
+    return measure(count, [&] {
+      for (auto& promise : promises) {
+        futures.push_back(promise.get_future());
+      }
+      std::thread producer([&] {
+        for (std::size_t i = 0UL; i < count; ++i) {
+          promises[i].set_value(i);
+        }
+      });
+      for (auto& future : futures) {
+        sum += future.get();
+      }
+      producer.join();
+    });
+  }
+}
+
+int main(int argc, char** argv)
+{
+  std::size_t const count = (argc > 1) ? std::stoul(argv[1]) : 1000000UL;
+  std::size_t sum = 0UL;
+
+  std::cout << "Benchmark: Create, fulfill and consume " << count
+            << " promise and future pairs (per pair)" << std::endl;
+
+  std::cout << "    fu2::promise:" << std::endl
+            << "        get:              "
+            << wait_local<fu2::promise>(count, sum) << "ns" << std::endl
+            << "        continuation:     "
+            << continue_local(count, sum) << "ns" << std::endl
+            << "        get (threaded):   "
+            << wait_remote<fu2::promise>(count, sum) << "ns" << std::endl;
+
+  std::cout << "    std::promise:" << std::endl
+            << "        get:              "
+            << wait_local<std::promise>(count, sum) << "ns" << std::endl
+            << "        get (threaded):   "
+            << wait_remote<std::promise>(count, sum) << "ns" << std::endl;
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,246 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+// Measures handing off unique functions from producer threads, which
+// construct them, to consumer threads, which invoke and destroy them,
+// for different capture sizes and capacities on 1 to N cores.
+//
+// Every producer is paired with a consumer through a bounded queue.
+// Functions whose capture exceeds the capacity are allocated by the
+// producer and freed by the consumer, which stresses the allocator across
+// threads. The throughput counts the handed off functions of all pairs,
+// the latencies are sampled for every construction and destruction.
+//
+// Usage: function2_handoff_benchmark [functions per producer] [max threads]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "function2/function2.hpp"
+
+namespace {
+  using clock_type = std::chrono::steady_clock;
+
+  /// A functor with a capture of the given size
+  template<std::size_t Size>
+  struct payload {
+    unsigned char bytes[Size];
+
+    void operator()() {
+      ++bytes[0];
+    }
+  };
+
+  /// A bounded queue between a single producer and a single consumer
+  template<typename Function>
+  class queue {
+    std::vector<Function> slots_;
+    char padding0_[64];
+    std::atomic<std::size_t> head_;
+    char padding1_[64];
+    std::atomic<std::size_t> tail_;
+    char padding2_[64];
+
+  public:
+    explicit queue(std::size_t size) : slots_(size), head_(0UL), tail_(0UL) { }
+
+    void push(Function&& function) {
+      std::size_t const tail = tail_.load(std::memory_order_relaxed);
+      while (tail - head_.load(std::memory_order_acquire) == slots_.size()) {
+        std::this_thread::yield();
+      }
+      slots_[tail % slots_.size()] = std::move(function);
+      tail_.store(tail + 1UL, std::memory_order_release);
+    }
+
+    Function pop() {
+      std::size_t const head = head_.load(std::memory_order_relaxed);
+      while (tail_.load(std::memory_order_acquire) == head) {
+        std::this_thread::yield();
+      }
+      Function function = std::move(slots_[head % slots_.size()]);
+      head_.store(head + 1UL, std::memory_order_release);
+      return function;
+    }
+  };
+
+  /// Returns the nanoseconds which elapsed since the given time
+  std::uint64_t elapsed(clock_type::time_point begin) {
+    return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        clock_type::now() - begin).count());
+  }
+
+  /// Returns the given percentile of the sorted latencies
+  std::uint64_t percentile(std::vector<std::uint64_t> const& sorted,
+                           double fraction) {
+    if (sorted.empty())
+      return 0U;
+    return sorted[std::min(sorted.size() - 1UL, static_cast<std::size_t>(
+      fraction * static_cast<double>(sorted.size())))];
+  }
+
+  void report(char const* name, std::vector<std::uint64_t>& latencies) {
+    std::sort(latencies.begin(), latencies.end());
+    std::cout << name << " p50 " << percentile(latencies, 0.5)
+              << "ns, p99 " << percentile(latencies, 0.99)
+              << "ns, p999 " << percentile(latencies, 0.999) << "ns";
+  }
+
+  void report(unsigned threads, std::size_t functions, double seconds,
+              std::vector<std::uint64_t>& construction,
+              std::vector<std::uint64_t>& destruction) {
+    std::cout << "        " << threads
+              << ((threads == 1U) ? " thread:  " : " threads: ")
+              << static_cast<long long>(static_cast<double>(functions) /
+                                        seconds)
+              << " functions/s" << std::endl << "            ";
+    report("construct", construction);
+    std::cout << std::endl << "            ";
+    report("destroy  ", destruction);
+    std::cout << std::endl;
+  }
+
+  /// Constructs, invokes and destroys every function on the same thread
+  template<std::size_t Capacity, std::size_t Size>
+  void run_local(std::size_t functions) {
+    using function_t = fu2::function_base<void(), false, Capacity>;
+
+    std::vector<std::uint64_t> construction;
+    std::vector<std::uint64_t> destruction;
+    construction.reserve(functions);
+    destruction.reserve(functions);
+
+    auto const begin = clock_type::now();
+    for (std::size_t j = 0UL; j < functions; ++j) {
+      payload<Size> captured;
+      captured.bytes[0] = static_cast<unsigned char>(j);
+
+      auto const constructed = clock_type::now();
+      function_t function(captured);
+      construction.push_back(elapsed(constructed));
+      function();
+
+      auto const destroyed = clock_type::now();
+      function = nullptr;
+      destruction.push_back(elapsed(destroyed));
+    }
+    double const seconds =
+      std::chrono::duration<double>(clock_type::now() - begin).count();
+
+    report(1U, functions, seconds, construction, destruction);
+  }
+
+  /// Hands off the functions from every producer to its consumer
+  template<std::size_t Capacity, std::size_t Size>
+  void run(unsigned pairs, std::size_t functions) {
+    using function_t = fu2::function_base<void(), false, Capacity>;
+
+    std::vector<std::unique_ptr<queue<function_t>>> queues;
+    std::vector<std::vector<std::uint64_t>> constructions(pairs);
+    std::vector<std::vector<std::uint64_t>> destructions(pairs);
+    for (unsigned i = 0U; i < pairs; ++i) {
+      queues.emplace_back(new queue<function_t>(1024UL));
+      constructions[i].reserve(functions);
+      destructions[i].reserve(functions);
+    }
+
+    std::vector<std::thread> threads;
+    auto const begin = clock_type::now();
+    for (unsigned i = 0U; i < pairs; ++i) {
+      threads.emplace_back([&, i] {
+        for (std::size_t j = 0UL; j < functions; ++j) {
+          payload<Size> captured;
+          captured.bytes[0] = static_cast<unsigned char>(j);
+
+          auto const constructed = clock_type::now();
+          function_t function(captured);
+          constructions[i].push_back(elapsed(constructed));
+          queues[i]->push(std::move(function));
+        }
+      });
+      threads.emplace_back([&, i] {
+        for (std::size_t j = 0UL; j < functions; ++j) {
+          function_t function = queues[i]->pop();
+          function();
+
+          auto const destroyed = clock_type::now();
+          function = nullptr;
+          destructions[i].push_back(elapsed(destroyed));
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    double const seconds =
+      std::chrono::duration<double>(clock_type::now() - begin).count();
+
+    std::vector<std::uint64_t> construction;
+    std::vector<std::uint64_t> destruction;
+    for (unsigned i = 0U; i < pairs; ++i) {
+      construction.insert(construction.end(), constructions[i].begin(),
+                          constructions[i].end());
+      destruction.insert(destruction.end(), destructions[i].begin(),
+                         destructions[i].end());
+    }
+
+    report(pairs * 2U, functions * pairs, seconds, construction, destruction);
+  }
+
+  template<std::size_t Capacity, std::size_t Size>
+  void scale(unsigned max_threads, std::size_t functions) {
+    std::cout << "    capacity " << Capacity << ", capture " << Size
+              << " bytes ("
+              << ((Size <= Capacity) ? "in-place" : "allocated") << "):"
+              << std::endl;
+
+    run_local<Capacity, Size>(functions);
+
+    // Doubles the count of pairs until all threads are used
+    unsigned const max_pairs = std::max(max_threads / 2U, 1U);
+    for (unsigned pairs = 1U; pairs <= max_pairs;) {
+      run<Capacity, Size>(pairs, functions);
+
+      pairs = ((pairs < max_pairs) && (pairs * 2U > max_pairs))
+        ? max_pairs
+        : pairs * 2U;
+    }
+  }
+
+  template<std::size_t Capacity>
+  void scale_captures(unsigned max_threads, std::size_t functions) {
+    scale<Capacity, 8UL>(max_threads, functions);
+    scale<Capacity, 32UL>(max_threads, functions);
+    scale<Capacity, 64UL>(max_threads, functions);
+    scale<Capacity, 256UL>(max_threads, functions);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  std::size_t const functions = (argc > 1) ? std::stoul(argv[1]) : 200000UL;
+  unsigned const cores = std::thread::hardware_concurrency();
+  unsigned const max_threads = (argc > 2)
+    ? static_cast<unsigned>(std::stoul(argv[2]))
+    : std::max(cores, 2U);
+
+  std::cout << "Benchmark: Hand off " << functions
+            << " unique functions per producer to a consumer (up to "
+            << max_threads << " threads)" << std::endl;
+
+  scale_captures<fu2::detail::default_capacity::value>(max_threads, functions);
+  scale_captures<64UL>(max_threads, functions);
+  scale_captures<256UL>(max_threads, functions);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,97 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+// Measures the latency of cache hits of memoized functions compared to
+// invoking the functor through a fu2::function directly, for a cheap
+// functor and for an expensive one which iterates a series.
+//
+// Usage: function2_memoized_benchmark [keys] [lookups] [iterations]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "function2/memoized.hpp"
+
+namespace {
+  using clock_type = std::chrono::steady_clock;
+
+  /// Returns the nanoseconds per lookup of the given function
+  template<typename Function>
+  double measure(Function& function, std::vector<std::uint64_t> const& keys,
+                 double& sink) {
+    auto const begin = clock_type::now();
+    for (std::uint64_t key : keys) {
+      sink += function(key);
+    }
+    auto const end = clock_type::now();
+    return std::chrono::duration<double, std::nano>(end - begin).count() /
+           static_cast<double>(keys.size());
+  }
+
+  template<typename Functor>
+  void run(char const* name, Functor const& functor, std::size_t distinct,
+           std::vector<std::uint64_t> const& keys) {
+    double sink = 0.0;
+
+    fu2::function<double(std::uint64_t) const> direct = functor;
+    fu2::memoized<double(std::uint64_t)> memoized(functor, distinct);
+    fu2::concurrent_memoized<double(std::uint64_t)> concurrent(
+      functor, 2UL * distinct);
+
+    // Warms up the caches so every measured lookup hits
+    for (std::uint64_t key = 0U; key < distinct; ++key) {
+      memoized(key);
+      concurrent(key);
+    }
+
+    double const direct_latency = measure(direct, keys, sink);
+    double const memoized_latency = measure(memoized, keys, sink);
+    double const concurrent_latency = measure(concurrent, keys, sink);
+
+    std::cout << "    " << name << std::endl
+              << "        fu2::function:            "
+              << direct_latency << "ns" << std::endl
+              << "        fu2::memoized:            "
+              << memoized_latency << "ns" << std::endl
+              << "        fu2::concurrent_memoized: "
+              << concurrent_latency << "ns" << std::endl;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  std::size_t const distinct = (argc > 1) ? std::stoul(argv[1]) : 1024UL;
+  std::size_t const lookups = (argc > 2) ? std::stoul(argv[2]) : 10000000UL;
+  std::size_t const iterations = (argc > 3) ? std::stoul(argv[3]) : 256UL;
+
+  std::mt19937_64 random(42U);
+  std::uniform_int_distribution<std::uint64_t> key_of(0U, distinct - 1U);
+  std::vector<std::uint64_t> keys(lookups);
+  for (auto& key : keys) {
+    key = key_of(random);
+  }
+
+  std::cout << "Benchmark: Look up " << lookups << " results of "
+            << distinct << " distinct keys which are cached (per lookup)"
+            << std::endl;
+
+  run("cheap functor:", [](std::uint64_t key) {
+    return static_cast<double>(key) * 0.5;
+  }, distinct, keys);
+
+  run("expensive functor:", [iterations](std::uint64_t key) {
+    double result = 0.0;
+    for (std::size_t i = 1UL; i <= iterations; ++i) {
+      result += static_cast<double>(key % i) / static_cast<double>(i);
+    }
+    return result;
+  }, distinct, keys);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,112 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+// Measures the frames per second of a task graph with wide fan-outs and
+// fan-ins, which is run on 1 to N threads and reused for every frame,
+// compared to invoking the same tasks sequentially without dependencies.
+//
+// Every frame consists of several layers, each layer fans out from a single
+// task to many parallel tasks which are joined by the next layer.
+//
+// Usage: function2_task_graph_benchmark [frames] [width] [layers] [work]
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "function2/task_graph.hpp"
+
+namespace {
+  /// Simulates the work of a single task
+  struct job {
+    std::atomic<unsigned>* sink;
+    unsigned work;
+
+    void operator()() const {
+      unsigned value = work;
+      for (unsigned i = 0U; i < work; ++i) {
+        value = value * 1664525U + 1013904223U;
+      }
+      sink->fetch_add(value, std::memory_order_relaxed);
+    }
+  };
+
+  template<typename Run>
+  double frames_per_second(std::size_t frames, Run&& run) {
+    auto const begin = std::chrono::steady_clock::now();
+    for (std::size_t frame = 0UL; frame < frames; ++frame) {
+      run();
+    }
+    auto const end = std::chrono::steady_clock::now();
+    return static_cast<double>(frames) /
+           std::chrono::duration<double>(end - begin).count();
+  }
+}
+
+int main(int argc, char** argv)
+{
+  std::size_t const frames = (argc > 1) ? std::stoul(argv[1]) : 2000UL;
+  std::size_t const width = (argc > 2) ? std::stoul(argv[2]) : 256UL;
+  std::size_t const layers = (argc > 3) ? std::stoul(argv[3]) : 4UL;
+  unsigned const work =
+    (argc > 4) ? static_cast<unsigned>(std::stoul(argv[4])) : 200U;
+  unsigned const cores = std::thread::hardware_concurrency();
+  unsigned const max_threads = cores ? cores : 1U;
+
+  std::atomic<unsigned> sink(0U);
+  job const task{&sink, work};
+
+  fu2::task_graph<> graph;
+  std::vector<fu2::unique_function<void()>> sequential;
+
+  auto join = graph.emplace(task);
+  sequential.emplace_back(task);
+  for (std::size_t layer = 0UL; layer < layers; ++layer) {
+    auto const next = graph.emplace(task);
+    sequential.emplace_back(task);
+    for (std::size_t i = 0UL; i < width; ++i) {
+      auto const stage = graph.emplace(task);
+      sequential.emplace_back(task);
+      graph.precede(join, stage);
+      graph.precede(stage, next);
+    }
+    join = next;
+  }
+
+  std::cout << "Benchmark: Run a graph of " << graph.size() << " tasks ("
+            << layers << " layers with a fan-out of " << width << ", "
+            << frames << " frames)" << std::endl;
+
+  double const sequential_rate = frames_per_second(frames, [&] {
+    for (auto& current : sequential) {
+      current();
+    }
+  });
+
+  std::cout << "    sequential invocation:  "
+            << static_cast<long long>(sequential_rate) << " frames/s"
+            << std::endl;
+
+  for (unsigned threads = 1U; threads <= max_threads; threads *= 2U) {
+    fu2::worker_pool pool(threads - 1U);
+    double const graph_rate = frames_per_second(frames, [&] {
+      graph.run(pool);
+    });
+
+    std::cout << "    fu2::task_graph " << threads << " threads: "
+              << static_cast<long long>(graph_rate) << " frames/s ("
+              << static_cast<long long>(
+                   (1000000000.0 / graph_rate) / graph.size())
+              << "ns per task)" << std::endl;
+
+    if ((threads < max_threads) && (threads * 2U > max_threads))
+      threads = max_threads / 2U;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,135 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+// Measures scheduling 1M concurrent timers, cancelling most of them and
+// expiring the remaining ones through a timer wheel, compared to timers
+// which are kept inside a std::multimap ordered by their expiry.
+//
+// Usage: function2_timer_wheel_benchmark [timers] [cancel percentage]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include "function2/timer_wheel.hpp"
+
+namespace {
+  using clock_type = std::chrono::steady_clock;
+
+  /// Timers inside a multimap which is ordered by their expiry
+  class multimap_timers {
+    using map_t = std::multimap<std::uint64_t, fu2::unique_function<void()>>;
+
+    map_t timers_;
+    std::uint64_t now_ = 0U;
+
+  public:
+    using timer = map_t::iterator;
+
+    void reserve(std::size_t) { }
+
+    template<typename T>
+    timer schedule(std::uint64_t delay, T&& callback) {
+      return timers_.emplace(now_ + delay, std::forward<T>(callback));
+    }
+
+    bool cancel(timer handle) {
+      timers_.erase(handle);
+      return true;
+    }
+
+    std::size_t advance(std::uint64_t ticks) {
+      std::size_t expired = 0UL;
+      now_ += ticks;
+      while (!timers_.empty() && (timers_.begin()->first <= now_)) {
+        auto callback = std::move(timers_.begin()->second);
+        timers_.erase(timers_.begin());
+        callback();
+        ++expired;
+      }
+      return expired;
+    }
+  };
+
+  /// Returns the nanoseconds per operation of the given action
+  template<typename Action>
+  double measure(std::size_t operations, Action&& action) {
+    auto const begin = clock_type::now();
+    action();
+    auto const end = clock_type::now();
+    return std::chrono::duration<double, std::nano>(end - begin).count() /
+           static_cast<double>(operations ? operations : 1UL);
+  }
+
+  template<typename Timers>
+  void run(char const* name, std::size_t count, unsigned cancel_percentage) {
+    std::mt19937_64 random(42U);
+    std::uniform_int_distribution<std::uint64_t> delays(1U, 65535U);
+    std::uniform_int_distribution<unsigned> percentage(0U, 99U);
+
+    Timers timers;
+    std::vector<typename Timers::timer> handles;
+    handles.reserve(count);
+    std::vector<std::uint64_t> delay(count);
+    std::vector<bool> is_cancelled(count);
+    for (std::size_t i = 0UL; i < count; ++i) {
+      delay[i] = delays(random);
+      is_cancelled[i] = percentage(random) < cancel_percentage;
+    }
+    std::size_t const cancels = static_cast<std::size_t>(
+      std::count(is_cancelled.begin(), is_cancelled.end(), true));
+
+    std::size_t fired = 0UL;
+    timers.reserve(count);
+
+    double const scheduled = measure(count, [&] {
+      for (std::size_t i = 0UL; i < count; ++i) {
+        handles.push_back(timers.schedule(delay[i], [&fired, i] {
+          fired += i & 1UL;
+        }));
+      }
+    });
+
+    double const cancelled = measure(cancels, [&] {
+      for (std::size_t i = 0UL; i < count; ++i) {
+        if (is_cancelled[i])
+          timers.cancel(handles[i]);
+      }
+    });
+
+    std::size_t expired = 0UL;
+    double const expiry = measure(count - cancels, [&] {
+      expired = timers.advance(65536U);
+    });
+
+    std::cout << "    " << name << std::endl
+              << "        schedule: " << scheduled << "ns" << std::endl
+              << "        cancel:   " << cancelled << "ns ("
+              << cancels << " timers)" << std::endl
+              << "        expire:   " << expiry << "ns ("
+              << expired << " timers)" << std::endl;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  std::size_t const count = (argc > 1) ? std::stoul(argv[1]) : 1000000UL;
+  unsigned const cancel_percentage =
+    (argc > 2) ? static_cast<unsigned>(std::stoul(argv[2])) : 90U;
+
+  std::cout << "Benchmark: Schedule " << count
+            << " concurrent timers within 65536 ticks and cancel "
+            << cancel_percentage << "% of them (per timer)" << std::endl;
+
+  run<fu2::timer_wheel<>>("fu2::timer_wheel:", count, cancel_percentage);
+  run<multimap_timers>("std::multimap:", count, cancel_percentage);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,326 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef FU2_INCLUDED_ATOMIC_FUNCTION_HPP__
+#define FU2_INCLUDED_ATOMIC_FUNCTION_HPP__
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <type_traits>
+#include "function2/function2.hpp"
+
+namespace fu2 {
+namespace detail {
+inline namespace v4 {
+namespace epoch {
+
+// An object which was unpublished and is destroyed as soon as
+// no reader is able to observe it anymore.
+struct retired {
+  typedef void(*destroy_t)(retired* /*object*/);
+
+  explicit retired(destroy_t destroy_)
+    : next(nullptr), epoch(0UL), destroy(destroy_) { }
+
+  retired* next;
+  // The global epoch at the time the object was retired
+  std::size_t epoch;
+  destroy_t const destroy;
+};
+
+// The reader state of a single thread, records are never freed
+// and reused by other threads after the owning thread exited.
+struct reader {
+  reader() : state(0UL), is_used(true), next(nullptr), nesting(0UL) { }
+
+  // The epoch the reader is pinned to shifted left by one and or'ed
+  // with one while the reader is inside a critical section, zero otherwise.
+  std::atomic<std::size_t> state;
+  std::atomic<bool> is_used;
+  reader* next;
+  // The count of nested critical sections, only used by the owning thread
+  std::size_t nesting;
+  // Keeps the states of different readers on different cache lines
+  char padding[64];
+};
+
+// An epoch based reclamation domain which is shared between all
+// atomic functions, a template to provide a definition inside every
+// translation unit.
+//
+// Readers only publish the current epoch when entering a critical section
+// which is wait-free. Writers retire unpublished objects with the current
+// epoch and advance the epoch when all readers inside a critical section
+// observed it. Objects are destroyed two epochs after they were retired,
+// when every reader which could have observed them left its critical section.
+template<typename = void>
+struct domain {
+  static std::atomic<std::size_t> current;
+  static std::atomic<reader*> readers;
+  // Guards the list of retired objects
+  static std::mutex mutex;
+  static retired* retired_list;
+
+  // Acquires a reader record for the lifetime of the current thread
+  class reader_handle {
+    reader* record_;
+
+  public:
+    reader_handle() : record_(acquire()) { }
+    reader_handle(reader_handle const&) = delete;
+    reader_handle& operator=(reader_handle const&) = delete;
+    ~reader_handle() {
+      record_->is_used.store(false, std::memory_order_release);
+    }
+
+    reader& get() const {
+      return *record_;
+    }
+  };
+
+  static reader* acquire() {
+    for (reader* record = readers.load(std::memory_order_acquire);
+         record; record = record->next) {
+      bool expected = false;
+      if (!record->is_used.load(std::memory_order_relaxed) &&
+          record->is_used.compare_exchange_strong(
+            expected, true, std::memory_order_acquire)) {
+        return record;
+      }
+    }
+
+    reader* record = new reader();
+    record->next = readers.load(std::memory_order_relaxed);
+    while (!readers.compare_exchange_weak(record->next, record,
+      std::memory_order_release, std::memory_order_relaxed)) { }
+    return record;
+  }
+
+  static reader& local_reader() {
+    static thread_local reader_handle const handle;
+    return handle.get();
+  }
+
+  // Enters a critical section in which retired objects stay alive
+  static void pin(reader& record) {
+    if (record.nesting++ == 0UL) {
+      std::size_t const epoch = current.load(std::memory_order_acquire);
+      record.state.store((epoch << 1) | 1UL, std::memory_order_relaxed);
+      // Orders the publication before any read of a published object
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+  }
+
+  // Leaves the critical section
+  static void unpin(reader& record) {
+    if (--record.nesting == 0UL) {
+      record.state.store(0UL, std::memory_order_release);
+    }
+  }
+
+  // Advances the epoch when every pinned reader observed the current one,
+  // requires the mutex to be locked.
+  static bool try_advance() {
+    std::size_t const epoch = current.load(std::memory_order_relaxed);
+    // Orders the preceding unpublication before reading the reader states
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    for (reader* record = readers.load(std::memory_order_acquire);
+         record; record = record->next) {
+      std::size_t const state = record->state.load(std::memory_order_acquire);
+      if ((state & 1UL) && ((state >> 1) != epoch))
+        return false;
+    }
+
+    current.store(epoch + 1UL, std::memory_order_release);
+    return true;
+  }
+
+  // Retires the given object which isn't reachable for new readers anymore,
+  // and destroys every retired object which can't be observed anymore.
+  static void retire(retired* object) {
+    retired* expired = nullptr;
+
+    {
+      std::lock_guard<std::mutex> const lock(mutex);
+      if (object) {
+        object->epoch = current.load(std::memory_order_relaxed);
+        object->next = retired_list;
+        retired_list = object;
+      }
+
+      // Two advances are sufficient to expire all retired objects
+      if (try_advance())
+        try_advance();
+
+      std::size_t const epoch = current.load(std::memory_order_relaxed);
+      for (retired** itr = &retired_list; *itr;) {
+        retired* const candidate = *itr;
+        if (candidate->epoch + 2UL <= epoch) {
+          *itr = candidate->next;
+          candidate->next = expired;
+          expired = candidate;
+        } else {
+          itr = &candidate->next;
+        }
+      }
+    }
+
+    // Destroys the objects outside of the lock,
+    // since their destructors could retire objects themselves.
+    while (expired) {
+      retired* const next = expired->next;
+      expired->destroy(expired);
+      expired = next;
+    }
+  }
+
+  // Destroys every retired object which can't be observed anymore
+  static void collect() {
+    retire(nullptr);
+  }
+};
+
+template<typename T>
+std::atomic<std::size_t> domain<T>::current(0UL);
+template<typename T>
+std::atomic<reader*> domain<T>::readers(nullptr);
+template<typename T>
+std::mutex domain<T>::mutex;
+template<typename T>
+retired* domain<T>::retired_list = nullptr;
+
+// Keeps the current thread pinned while it is alive
+class pin_guard {
+  reader& record_;
+
+public:
+  pin_guard() : record_(domain<>::local_reader()) {
+    domain<>::pin(record_);
+  }
+  pin_guard(pin_guard const&) = delete;
+  pin_guard& operator=(pin_guard const&) = delete;
+  ~pin_guard() {
+    domain<>::unpin(record_);
+  }
+};
+
+} /// namespace epoch
+} /// inline namespace
+} /// namespace detail
+
+template<typename /*Signature*/>
+class atomic_function;
+
+/// A function slot which can be read from many threads concurrently
+/// while another thread replaces its target.
+///
+/// Invoking the function is wait-free, it only publishes the thread
+/// as a reader without taking any lock. Stored targets are type erased
+/// through a `fu2::unique_function<ReturnType(Args...) const>`,
+/// since they are invoked concurrently, targets which were replaced
+/// are destroyed as soon as no thread is invoking them anymore.
+///
+/// Like `std::atomic` the slot itself isn't copyable nor movable.
+template<typename ReturnType, typename... Args>
+class atomic_function<ReturnType(Args...)> {
+  using function_t = unique_function<ReturnType(Args...) const>;
+
+  struct node : detail::epoch::retired {
+    template<typename T>
+    explicit node(T&& target)
+      : retired(destroy), function(std::forward<T>(target)) { }
+
+    static void destroy(retired* object) {
+      delete static_cast<node*>(object);
+    }
+
+    function_t function;
+  };
+
+  std::atomic<node*> current_;
+
+  template<typename T>
+  static node* make_node(T&& target) {
+    return new node(std::forward<T>(target));
+  }
+
+  void publish(node* next) {
+    node* const previous = current_.exchange(next, std::memory_order_acq_rel);
+    if (previous)
+      detail::epoch::domain<>::retire(previous);
+  }
+
+public:
+  /// Constructs the function empty
+  constexpr atomic_function() noexcept : current_(nullptr) { }
+
+  /// Constructs the function empty
+  constexpr explicit atomic_function(std::nullptr_t) noexcept
+    : current_(nullptr) { }
+
+  /// Constructs the function from the given functional object
+  template<typename T,
+           typename std::enable_if<
+            std::is_constructible<function_t, T&&>::value
+           >::type* = nullptr>
+  explicit atomic_function(T&& target)
+    : current_(make_node(std::forward<T>(target))) { }
+
+  atomic_function(atomic_function const&) = delete;
+  atomic_function& operator=(atomic_function const&) = delete;
+
+  /// Retires the current target
+  ~atomic_function() {
+    publish(nullptr);
+  }
+
+  /// Publishes the given functional object as new target, the previous
+  /// target is destroyed when no thread is invoking it anymore.
+  template<typename T,
+           typename std::enable_if<
+            std::is_constructible<function_t, T&&>::value
+           >::type* = nullptr>
+  void store(T&& target) {
+    publish(make_node(std::forward<T>(target)));
+  }
+
+  /// Empties the function, the previous target is destroyed
+  /// when no thread is invoking it anymore.
+  void store(std::nullptr_t) {
+    publish(nullptr);
+  }
+
+  /// Returns true when the function is empty
+  bool empty() const noexcept {
+    return current_.load(std::memory_order_acquire) == nullptr;
+  }
+
+  /// Returns true when the function isn't empty
+  explicit operator bool() const noexcept {
+    return !empty();
+  }
+
+  /// Calls the current target, throws a fu2::bad_function_call when the
+  /// function is empty and exceptions are enabled,
+  /// std::abort is called otherwise.
+  ReturnType operator()(Args... args) const {
+    detail::epoch::pin_guard const guard;
+    node const* const target = current_.load(std::memory_order_acquire);
+    if (!target) {
+      return detail::vtable_creator_of_empty_function<
+        detail::signature<ReturnType(Args...)>, true
+      >::invoke(nullptr, std::forward<Args>(args)...);
+    }
+    return target->function(std::forward<Args>(args)...);
+  }
+};
+
+} /// namespace fu2
+
+#endif // FU2_INCLUDED_ATOMIC_FUNCTION_HPP__
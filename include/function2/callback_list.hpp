@@ -0,0 +1,412 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef FU2_INCLUDED_CALLBACK_LIST_HPP__
+#define FU2_INCLUDED_CALLBACK_LIST_HPP__
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include <type_traits>
+#include "function2/function2.hpp"
+#include "function2/atomic_function.hpp"
+
+namespace fu2 {
+namespace detail {
+inline namespace v4 {
+namespace callbacks {
+
+template<typename Handler>
+struct arena;
+
+// A subscribed handler which is stored in-place inside the arena.
+//
+// Nodes are released twice before they are reused: once when the
+// handler was destroyed and once when no snapshot refers to it anymore.
+template<typename Handler>
+struct node : epoch::retired {
+  node()
+    : retired(destroy_handler), is_subscribed(false), releases(0U),
+      owner(nullptr), next_free(nullptr), generation(0UL) { }
+
+  // Destroys the handler of an unsubscribed node
+  static void destroy_handler(retired* object) {
+    node* const current = static_cast<node*>(object);
+    arena<Handler>* const owner = current->owner;
+    current->handler = nullptr;
+    owner->release(current);
+    owner->unreference();
+  }
+
+  Handler handler;
+  std::atomic<bool> is_subscribed;
+  std::atomic<unsigned> releases;
+  arena<Handler>* owner;
+  node* next_free;
+  // Distinguishes the subscriptions of a reused node
+  std::size_t generation;
+};
+
+// Owns the nodes of a callback list, it outlives the list until
+// every retired snapshot and handler which refers to it was destroyed.
+template<typename Handler>
+struct arena {
+  using node_t = node<Handler>;
+
+  arena() : references(1UL), released(nullptr), free(nullptr), used(0UL) { }
+
+  void reference() {
+    references.fetch_add(1UL, std::memory_order_relaxed);
+  }
+
+  void unreference() {
+    if (references.fetch_sub(1UL, std::memory_order_acq_rel) == 1UL)
+      delete this;
+  }
+
+  // Returns the node to the arena when it was released twice
+  void release(node_t* current) {
+    if (current->releases.fetch_sub(1U, std::memory_order_acq_rel) == 1U) {
+      current->next_free = released.load(std::memory_order_relaxed);
+      while (!released.compare_exchange_weak(current->next_free, current,
+        std::memory_order_release, std::memory_order_relaxed)) { }
+    }
+  }
+
+  // Returns an unused node, requires the writer lock
+  node_t* allocate() {
+    if (!free)
+      free = released.exchange(nullptr, std::memory_order_acquire);
+
+    if (free) {
+      node_t* const current = free;
+      free = current->next_free;
+      return current;
+    }
+
+    // Nodes are allocated inside chunks of a growing size
+    // and never move while the arena is alive.
+    if (chunks.empty() || (used == chunk_size(chunks.size() - 1))) {
+      chunks.emplace_back(new node_t[chunk_size(chunks.size())]);
+      used = 0UL;
+    }
+    node_t* const current = &chunks.back()[used++];
+    current->owner = this;
+    return current;
+  }
+
+  // Returns a node which was never published, requires the writer lock
+  void deallocate(node_t* current) {
+    current->handler = nullptr;
+    current->next_free = free;
+    free = current;
+  }
+
+  static std::size_t chunk_size(std::size_t index) {
+    return 8UL << (index < 16UL ? index : 16UL);
+  }
+
+  std::atomic<std::size_t> references;
+  // Nodes which were released concurrently through retirements
+  std::atomic<node_t*> released;
+  // Nodes which are ready to be reused, only accessed by writers
+  node_t* free;
+  std::vector<std::unique_ptr<node_t[]>> chunks;
+  std::size_t used;
+};
+
+// Returns an allocated node to the arena unless it was published,
+// which cleans up when storing the handler or compacting throws.
+template<typename Handler>
+class allocation_guard {
+  arena<Handler>* owner_;
+  node<Handler>* current_;
+
+public:
+  allocation_guard(arena<Handler>& owner, node<Handler>* current)
+    : owner_(&owner), current_(current) { }
+  allocation_guard(allocation_guard const&) = delete;
+  allocation_guard& operator=(allocation_guard const&) = delete;
+  ~allocation_guard() {
+    if (current_)
+      owner_->deallocate(current_);
+  }
+
+  void release() {
+    current_ = nullptr;
+  }
+};
+
+// An immutable list of nodes which are invoked in order
+template<typename Handler>
+struct snapshot : epoch::retired {
+  using node_t = node<Handler>;
+
+  snapshot(arena<Handler>* owner_, std::size_t capacity)
+    : retired(destroy), owner(owner_), size(0UL),
+      entries(new node_t*[capacity]) { }
+
+  // Releases the nodes which were dropped by the succeeding snapshot
+  static void destroy(retired* object) {
+    snapshot* const current = static_cast<snapshot*>(object);
+    arena<Handler>* const owner = current->owner;
+    for (node_t* dropped : current->dropped)
+      owner->release(dropped);
+    delete current;
+    owner->unreference();
+  }
+
+  arena<Handler>* const owner;
+  std::size_t size;
+  std::unique_ptr<node_t*[]> entries;
+  std::vector<node_t*> dropped;
+};
+
+// Is a true type if every argument is passable as lvalue to all handlers,
+// which rejects rvalue references and arguments that aren't copyable.
+template<typename... Args>
+struct are_passable_as_lvalues : std::true_type { };
+
+template<typename First, typename... Rest>
+struct are_passable_as_lvalues<First, Rest...>
+  : std::integral_constant<bool,
+      !std::is_rvalue_reference<First>::value &&
+      std::is_constructible<
+        First, typename std::remove_reference<First>::type&
+      >::value &&
+      are_passable_as_lvalues<Rest...>::value
+    > { };
+
+} /// namespace callbacks
+} /// inline namespace
+} /// namespace detail
+
+template<typename /*Signature*/,
+         std::size_t Capacity = detail::default_capacity::value>
+class callback_list;
+
+/// A list of callbacks which are invoked in order of their subscription,
+/// for instance as event bus or signal.
+///
+/// Handlers are stored in-place inside nodes which are allocated in
+/// contiguous chunks owned by the list. Emitting never takes a lock,
+/// it walks an immutable snapshot of the subscribed handlers which is
+/// replaced on subscription (copy-on-write). Unsubscribed handlers are
+/// skipped immediately and destroyed as soon as no emit invokes them anymore.
+///
+/// Since the handlers are invoked concurrently when emitting from multiple
+/// threads they are required to be const callable, results are discarded.
+/// The arguments are passed to every handler as lvalues, thus signatures
+/// with rvalue reference or move only parameters are rejected.
+template<typename ReturnType, typename... Args, std::size_t Capacity>
+class callback_list<ReturnType(Args...), Capacity> {
+  static_assert(detail::callbacks::are_passable_as_lvalues<Args...>::value,
+                "The arguments are passed to every handler as lvalues, "
+                "rvalue reference and move only parameters aren't supported!");
+
+  using handler_t = function_base<ReturnType(Args...) const, false, Capacity>;
+  using arena_t = detail::callbacks::arena<handler_t>;
+  using node_t = detail::callbacks::node<handler_t>;
+  using snapshot_t = detail::callbacks::snapshot<handler_t>;
+
+public:
+  /// A handle to a subscribed handler
+  class subscription {
+    friend class callback_list;
+
+    node_t* node_;
+    std::size_t generation_;
+
+    subscription(node_t* node, std::size_t generation)
+      : node_(node), generation_(generation) { }
+
+  public:
+    constexpr subscription() noexcept : node_(nullptr), generation_(0UL) { }
+
+    /// Returns true when the subscription refers to a handler
+    explicit operator bool() const noexcept {
+      return node_ != nullptr;
+    }
+  };
+
+private:
+  arena_t* arena_;
+  std::atomic<snapshot_t*> current_;
+  // Guards all writers, is never locked while emitting
+  std::mutex mutex_;
+  std::size_t unsubscribed_;
+
+  // Publishes the given snapshot, and returns the previous one which
+  // releases the nodes that aren't part of the next snapshot on retirement.
+  // Requires the writer lock.
+  detail::epoch::retired* publish(snapshot_t* next,
+                                  std::vector<node_t*> dropped) {
+    snapshot_t* const previous =
+      current_.exchange(next, std::memory_order_acq_rel);
+
+    if (previous) {
+      previous->dropped = std::move(dropped);
+      arena_->reference();
+    }
+    return previous;
+  }
+
+  // Marks the given node as unsubscribed and returns it,
+  // its handler is destroyed on retirement. Requires the writer lock.
+  detail::epoch::retired* unpublish(node_t* entry) {
+    entry->is_subscribed.store(false, std::memory_order_release);
+    arena_->reference();
+    return entry;
+  }
+
+  // Retires the given objects, the writer lock must not be held since
+  // retiring destroys expired handlers which could access this list.
+  static void retire(detail::epoch::retired* first,
+                     detail::epoch::retired* second = nullptr) {
+    if (first)
+      detail::epoch::domain<>::retire(first);
+    if (second)
+      detail::epoch::domain<>::retire(second);
+  }
+
+  // Creates a snapshot of all subscribed nodes with the given capacity.
+  // Requires the writer lock.
+  snapshot_t* compact(std::size_t capacity, std::vector<node_t*>& dropped) {
+    snapshot_t* const previous = current_.load(std::memory_order_relaxed);
+    std::unique_ptr<snapshot_t> next(new snapshot_t(arena_, capacity));
+
+    if (previous) {
+      for (std::size_t i = 0; i < previous->size; ++i) {
+        node_t* const entry = previous->entries[i];
+        if (entry->is_subscribed.load(std::memory_order_relaxed))
+          next->entries[next->size++] = entry;
+        else
+          dropped.push_back(entry);
+      }
+    }
+
+    unsubscribed_ = 0UL;
+    return next.release();
+  }
+
+public:
+  /// Constructs the list empty
+  callback_list() : arena_(new arena_t()), current_(nullptr),
+                    unsubscribed_(0UL) { }
+
+  callback_list(callback_list const&) = delete;
+  callback_list& operator=(callback_list const&) = delete;
+
+  /// Unsubscribes all handlers, the handlers and the storage of the list
+  /// are destroyed when no emit invokes them anymore.
+  ~callback_list() {
+    snapshot_t* const last = current_.load(std::memory_order_relaxed);
+    if (last) {
+      for (std::size_t i = 0; i < last->size; ++i) {
+        node_t* const entry = last->entries[i];
+        if (entry->is_subscribed.load(std::memory_order_relaxed))
+          retire(unpublish(entry));
+      }
+
+      std::vector<node_t*> dropped(last->entries.get(),
+                                   last->entries.get() + last->size);
+      retire(publish(nullptr, std::move(dropped)));
+    }
+    arena_->unreference();
+  }
+
+  /// Subscribes the given handler at the end of the list
+  template<typename T,
+           typename std::enable_if<
+            std::is_constructible<handler_t, T&&>::value
+           >::type* = nullptr>
+  subscription subscribe(T&& handler) {
+    node_t* entry;
+    detail::epoch::retired* previous;
+
+    {
+      std::lock_guard<std::mutex> const lock(mutex_);
+
+      entry = arena_->allocate();
+      detail::callbacks::allocation_guard<handler_t> guard(*arena_, entry);
+      entry->handler = std::forward<T>(handler);
+
+      snapshot_t* const last = current_.load(std::memory_order_relaxed);
+      std::size_t const size = last ? (last->size - unsubscribed_) : 0UL;
+
+      std::vector<node_t*> dropped;
+      snapshot_t* const next = compact(size + 1UL, dropped);
+      next->entries[next->size++] = entry;
+      entry->releases.store(2U, std::memory_order_relaxed);
+      entry->is_subscribed.store(true, std::memory_order_relaxed);
+      ++entry->generation;
+      previous = publish(next, std::move(dropped));
+      guard.release();
+    }
+
+    retire(previous);
+    return subscription(entry, entry->generation);
+  }
+
+  /// Unsubscribes the handler of the given subscription, the handler isn't
+  /// invoked by emits which start after this call.
+  ///
+  /// Returns false when the handler was unsubscribed already.
+  bool unsubscribe(subscription const& handle) {
+    detail::epoch::retired* unsubscribed;
+    detail::epoch::retired* previous = nullptr;
+
+    {
+      std::lock_guard<std::mutex> const lock(mutex_);
+
+      node_t* const entry = handle.node_;
+      if (!entry || (entry->generation != handle.generation_) ||
+          !entry->is_subscribed.load(std::memory_order_relaxed)) {
+        return false;
+      }
+      unsubscribed = unpublish(entry);
+
+      // Drops the unsubscribed nodes from the snapshot when they
+      // make up the half of it, which amortizes the copy.
+      snapshot_t* const last = current_.load(std::memory_order_relaxed);
+      if (++unsubscribed_ * 2UL >= last->size) {
+        std::vector<node_t*> dropped;
+        snapshot_t* const next = compact(last->size - unsubscribed_, dropped);
+        previous = publish(next, std::move(dropped));
+      }
+    }
+
+    retire(unsubscribed, previous);
+    return true;
+  }
+
+  /// Invokes all subscribed handlers in order of their subscription,
+  /// the arguments are passed to every handler as lvalues.
+  void operator()(Args... args) const {
+    detail::epoch::pin_guard const guard;
+    snapshot_t const* const current = current_.load(std::memory_order_acquire);
+    if (!current)
+      return;
+
+    for (std::size_t i = 0; i < current->size; ++i) {
+      node_t const* const entry = current->entries[i];
+      if (entry->is_subscribed.load(std::memory_order_acquire))
+        entry->handler(args...);
+    }
+  }
+
+  /// Invokes all subscribed handlers in order of their subscription
+  void emit(Args... args) const {
+    (*this)(args...);
+  }
+};
+
+} /// namespace fu2
+
+#endif // FU2_INCLUDED_CALLBACK_LIST_HPP__
@@ -0,0 +1,191 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef FU2_INCLUDED_COROUTINE_HPP__
+#define FU2_INCLUDED_COROUTINE_HPP__
+
+#include "function2/function2.hpp"
+
+// Coroutines are only available when compiling with C++20,
+// the header is empty otherwise.
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+  #if __has_include(<coroutine>)
+    #define FU2_HAS_COROUTINES
+  #endif
+#endif
+
+#ifdef FU2_HAS_COROUTINES
+
+#include <atomic>
+#include <coroutine>
+#include <new>
+#include <utility>
+#include <type_traits>
+
+namespace fu2 {
+namespace detail {
+inline namespace v4 {
+namespace coroutines {
+
+// Stores the result which is passed to the completion handler
+template<typename T>
+class completion_result {
+  typename std::aligned_storage<sizeof(T), alignof(T)>::type storage_;
+  bool is_constructed_ = false;
+
+public:
+  completion_result() = default;
+  completion_result(completion_result const&) = delete;
+  completion_result& operator=(completion_result const&) = delete;
+  ~completion_result() {
+    if (is_constructed_)
+      reinterpret_cast<T*>(&storage_)->~T();
+  }
+
+  template<typename... Args>
+  void emplace(Args&&... args) {
+    new (&storage_) T(std::forward<Args>(args)...);
+    is_constructed_ = true;
+  }
+
+  T take() {
+    return std::move(*reinterpret_cast<T*>(&storage_));
+  }
+};
+
+template<>
+class completion_result<void> {
+public:
+  void emplace() { }
+  void take() { }
+};
+
+// The signature of the completion handler
+template<typename T>
+struct completion_signature {
+  using type = void(T);
+};
+
+template<>
+struct completion_signature<void> {
+  using type = void();
+};
+
+// The completion handler which is passed to the initiating function,
+// it is pointer sized and therefore stored in-place.
+template<typename Awaitable, typename /*Signature*/>
+class completion_handler;
+
+template<typename Awaitable, typename... Args>
+class completion_handler<Awaitable, void(Args...)> {
+  Awaitable* awaitable_;
+
+public:
+  explicit completion_handler(Awaitable* awaitable)
+    : awaitable_(awaitable) { }
+
+  void operator()(Args... args) {
+    awaitable_->complete(std::forward<Args>(args)...);
+  }
+};
+
+// Awaitable which passes a completion handler to the initiating function,
+// and resumes the awaiting coroutine on completion.
+template<typename T, typename Initiator>
+class completion_awaitable {
+  template<typename, typename>
+  friend class completion_handler;
+
+  enum : int {
+    state_initiating,
+    state_suspended,
+    state_completed
+  };
+
+  Initiator initiator_;
+  std::coroutine_handle<> continuation_;
+  std::atomic<int> state_{state_initiating};
+  completion_result<T> result_;
+
+  template<typename... Args>
+  void complete(Args&&... args) {
+    result_.emplace(std::forward<Args>(args)...);
+    // The coroutine is resumed here when it was suspended already,
+    // otherwise await_suspend returns without suspending it.
+    if (state_.exchange(state_completed, std::memory_order_acq_rel) ==
+        state_suspended) {
+      continuation_.resume();
+    }
+  }
+
+  using handler_t = completion_handler<
+    completion_awaitable, typename completion_signature<T>::type
+  >;
+
+public:
+  /// The completion handler type which is passed to the initiating function
+  using completion_type = unique_function<
+    typename completion_signature<T>::type
+  >;
+
+  explicit completion_awaitable(Initiator initiator)
+    : initiator_(std::move(initiator)) { }
+
+  completion_awaitable(completion_awaitable const&) = delete;
+  completion_awaitable& operator=(completion_awaitable const&) = delete;
+
+  bool await_ready() const noexcept {
+    return false;
+  }
+
+  bool await_suspend(std::coroutine_handle<> continuation) {
+    continuation_ = continuation;
+    std::move(initiator_)(completion_type(handler_t(this)));
+
+    // Doesn't suspend when the handler was invoked synchronously
+    int expected = state_initiating;
+    return state_.compare_exchange_strong(expected, state_suspended,
+                                          std::memory_order_acq_rel);
+  }
+
+  T await_resume() {
+    return result_.take();
+  }
+};
+
+} /// namespace coroutines
+} /// inline namespace
+} /// namespace detail
+
+/// Returns an awaitable which invokes the given initiating function with a
+/// `fu2::unique_function<void(T)>` completion handler (`void()` when T is
+/// void) and resumes the awaiting coroutine with the value passed to it.
+///
+/// The completion handler is stored in-place of the function, awaiting
+/// doesn't allocate any memory. The handler is invoked exactly once, either
+/// synchronously inside the initiating function or later from any thread,
+/// the coroutine is never resumed when the handler is destroyed uninvoked:
+/// ```
+/// std::size_t bytes = co_await fu2::await_completion<std::size_t>(
+///   [&](fu2::unique_function<void(std::size_t)> done) {
+///     socket.async_read(buffer, std::move(done));
+///   });
+/// ```
+template<typename T, typename Initiator>
+detail::coroutines::completion_awaitable<
+  T, typename std::decay<Initiator>::type
+>
+await_completion(Initiator&& initiator) {
+  return detail::coroutines::completion_awaitable<
+    T, typename std::decay<Initiator>::type
+  >(std::forward<Initiator>(initiator));
+}
+
+} /// namespace fu2
+
+#endif // FU2_HAS_COROUTINES
+
+#endif // FU2_INCLUDED_COROUTINE_HPP__
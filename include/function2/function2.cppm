@@ -0,0 +1,25 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+// C++20 module interface of function2:
+//
+//   import function2;
+//
+// The explicit instantiation macros aren't exported by modules,
+// include function2.hpp where those are required instead.
+
+module;
+
+#include "function2.hpp"
+
+export module function2;
+
+export namespace fu2 {
+using fu2::function_base;
+using fu2::function;
+using fu2::unique_function;
+using fu2::bad_function_call;
+} /// namespace fu2
@@ -9,6 +9,9 @@
 
 #include <tuple>
 #include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <utility>
 #include <exception>
 #include <type_traits>
 
@@ -34,6 +37,14 @@
     __builtin_expect(EXPRESSION, VALUE)
 #endif
 
+// Destructors are constexpr since C++20, which makes aggregates of
+// functions constant initializable.
+#if defined(__cpp_constexpr) && (__cpp_constexpr >= 201907L)
+  #define FU2_MACRO_CONSTEXPR_DESTRUCTOR constexpr
+#else
+  #define FU2_MACRO_CONSTEXPR_DESTRUCTOR
+#endif
+
 // If macro.
 #define FU2_MACRO_IF(cond) \
   FU2_MACRO_IF_ ## cond
@@ -68,6 +79,11 @@
     EXPRESSION(true, true, true)
 
 namespace fu2 {
+
+// Is defined below together with the public interface
+template<typename T>
+struct is_trivially_relocatable;
+
 namespace detail {
 inline namespace v4 {
 
@@ -131,9 +147,23 @@ struct qualifier {
   static constexpr auto const is_rvalue = RValue;
 };
 
+// The instrumentation policy of functions which aren't instrumented,
+// invocations are dispatched to the storage directly.
+//
+// Instrumentation policies wrap the invocations of functions through
+// a static invoke method with the same signature.
+struct no_instrumentation {
+  template<typename ReturnType, typename StorageType,
+           typename Storage, typename... CallArgs>
+  static ReturnType invoke(Storage& storage, CallArgs&&... args) {
+    return StorageType::invoke(storage, std::forward<CallArgs>(args)...);
+  }
+};
+
 // Helper to store the function configuration.
 template<bool Copyable, std::size_t Capacity,
-         bool Throws, bool PartialApplyable>
+         bool Throws, bool PartialApplyable, bool Compact = false,
+         typename Instrumentation = no_instrumentation>
 struct config {
   // Is true if the function is copyable.
   static constexpr auto const is_copyable = Copyable;
@@ -147,6 +177,13 @@ struct config {
 
   // Is true when the function is assignable with less arguments.
   static constexpr auto const is_partial_applyable = PartialApplyable;
+
+  // Is true when the function is pointer sized and stores the vtable
+  // inside the heap block of its functor.
+  static constexpr auto const is_compact = Compact;
+
+  // The policy which wraps the invocations of the function
+  using instrumentation = Instrumentation;
 };
 
 template<bool Condition, typename T>
@@ -189,7 +226,7 @@ using make_qualified_type_t =
 // Provides a static wrap method which routes the functor through
 struct invocation_wrapper_none {
   template<typename T>
-  static auto wrap(T&& functor) -> typename std::decay<T>::type {
+  static T&& wrap(T&& functor) {
     return std::forward<T>(functor);
   }
 };
@@ -372,42 +409,164 @@ using default_chance = std::integral_constant<std::size_t,
   2UL
 >;
 
-template<typename Signature, bool Copyable>
-struct function_vtable;
+// Identifies a type without RTTI through the address of a variable
+// which exists once for every type. The variable isn't const, so it
+// can't be merged with the variable of another type by the linker.
+template<typename T>
+struct type_id_tag {
+  static char id;
+};
+
+template<typename T>
+char type_id_tag<T>::id = 0;
+
+/// Identifies the type of a functor without RTTI,
+/// identifiers of the same type compare equal.
+class type_id {
+  void const* _id;
+
+public:
+  constexpr explicit type_id(void const* id) : _id(id) { }
+
+  friend constexpr bool operator== (type_id left, type_id right) {
+    return left._id == right._id;
+  }
+
+  friend constexpr bool operator!= (type_id left, type_id right) {
+    return left._id != right._id;
+  }
+};
 
-template<typename ReturnType, typename... Args, bool Copyable>
-struct function_vtable<signature<ReturnType(Args...)>, Copyable> {
+// Operations which only depend on the type of the stored functor,
+// those are shared between all signatures and qualifiers the type is
+// wrapped with.
+struct function_type_ops {
   typedef void(*destruct_t)(void* /*destination*/);
-  typedef ReturnType(*invoke_t)(void* /*destination*/, Args&&... /*args*/);
-  typedef std::size_t(*required_size_t)();
-  typedef void (*move_t)(void* /*from*/, void* /*to*/);
+  typedef void(*move_t)(void* /*from*/, void* /*to*/);
+  typedef void(*copy_t)(void* /*from*/, void* /*to*/);
 
-  constexpr function_vtable(destruct_t destruct_, invoke_t invoke_,
-    required_size_t required_size_, move_t move_)
-    : destruct(destruct_), invoke(invoke_),
-      required_size(required_size_), move(move_) { }
+  constexpr function_type_ops(destruct_t destruct_, move_t move_,
+    copy_t copy_, std::size_t size_, std::size_t alignment_,
+    void const* type_id_, bool is_trivially_relocatable_)
+    : destruct(destruct_), move(move_), copy(copy_),
+      size(size_), alignment(alignment_), type_id(type_id_),
+      is_trivially_relocatable(is_trivially_relocatable_) { }
 
   destruct_t const destruct;
-  invoke_t const invoke;
-  required_size_t const required_size;
+  // Is null for functors which aren't move constructible
   move_t const move;
+  // Is null for functors which are stored inside non copyable functions
+  copy_t const copy;
+  // The capacity which is required to allocate the functor in-place
+  std::size_t const size;
+  std::size_t const alignment;
+  // Identifies the functor type, it is void for empty functions
+  void const* const type_id;
+  // Is true when the functor is relocatable by copying its bytes
+  bool const is_trivially_relocatable;
+};
+
+// Describes where the functor of a vtable is stored
+enum class functor_location {
+  // The function is empty
+  none,
+  // The functor is stored inside the internal capacity
+  inplace,
+  // The functor is stored on the heap, the internal capacity
+  // holds the pointer to it.
+  heap
+};
+
+// The type which an argument is passed as through the vtable. Scalars are
+// passed by value, which keeps them inside registers and allows the call
+// operator to tail call the vtable, other arguments are passed by reference.
+template<typename T>
+using vtable_argument_t = typename std::conditional<
+  std::is_scalar<T>::value, T, T&&
+>::type;
+
+// Describes the batched invocation of functions with the given signature,
+// which invokes the functor once for every argument of a range.
+// Only signatures with a single argument which isn't modified
+// and a result which is assignable are invocable in batches.
+template<typename /*Signature*/>
+struct batch_traits {
+  using is_invocable = std::false_type;
+  using argument_t = void;
+  using result_t = void;
+  typedef void(*invoke_batch_t)();
+};
+
+template<typename ReturnType, typename Arg>
+struct batch_traits<signature<ReturnType(Arg)>> {
+  using argument_t = typename std::decay<Arg>::type;
+  using result_t = typename std::remove_reference<ReturnType>::type;
+
+  using is_invocable = std::integral_constant<bool,
+    !std::is_void<ReturnType>::value &&
+    !std::is_reference<ReturnType>::value &&
+    std::is_move_assignable<ReturnType>::value &&
+    !std::is_rvalue_reference<Arg>::value &&
+    (!std::is_lvalue_reference<Arg>::value ||
+     std::is_const<typename std::remove_reference<Arg>::type>::value) &&
+    std::is_constructible<Arg, argument_t const&>::value
+  >;
+
+  typedef typename std::conditional<
+    is_invocable::value,
+    void(*)(void* /*destination*/, argument_t const* /*first*/,
+            argument_t const* /*last*/, result_t* /*out*/),
+    void(*)()
+  >::type invoke_batch_t;
 };
 
+template<typename Signature>
+struct function_vtable;
+
 template<typename ReturnType, typename... Args>
-struct function_vtable<signature<ReturnType(Args...)>, true>
-   : function_vtable<signature<ReturnType(Args...)>, false> {
-  typedef void (*copy_t)(void* /*from*/, void* /*to*/);
-
-  constexpr function_vtable(
-      typename function_vtable::destruct_t destruct_,
-      typename function_vtable::invoke_t invoke_,
-      typename function_vtable::required_size_t required_size_,
-      typename function_vtable::move_t move_,
-      copy_t copy_)
-    : function_vtable<signature<ReturnType(Args...)>, false>
-      (destruct_, invoke_, required_size_, move_), copy(copy_) { }
+struct function_vtable<signature<ReturnType(Args...)>> {
+  typedef ReturnType(*invoke_t)(void* /*destination*/,
+                                vtable_argument_t<Args>... /*args*/);
+  using invoke_batch_t = typename batch_traits<
+    signature<ReturnType(Args...)>
+  >::invoke_batch_t;
+
+  constexpr function_vtable(invoke_t invoke_, invoke_batch_t invoke_batch_,
+                            function_type_ops const* ops_,
+                            functor_location location_,
+                            function_vtable const* heap_vtable_)
+    : invoke(invoke_), invoke_batch(invoke_batch_), ops(ops_),
+      location(location_), heap_vtable(heap_vtable_) { }
+
+  // Is invoked with the internal capacity of the function
+  invoke_t const invoke;
+  // Is invoked like invoke for a range of arguments,
+  // null when the signature isn't invocable in batches.
+  invoke_batch_t const invoke_batch;
+  function_type_ops const* const ops;
+  functor_location const location;
+  // The vtable which is used when the functor is moved to the heap
+  function_vtable const* const heap_vtable;
+};
 
-  copy_t const copy;
+// A raw function pointer and context pair which invokes the target of
+// a function, the function pointer is the invoke operation of the vtable.
+template<typename /*Signature*/>
+struct trampoline;
+
+template<typename ReturnType, typename... Args>
+struct trampoline<signature<ReturnType(Args...)>> {
+  using invoke_type = typename function_vtable<
+    signature<ReturnType(Args...)>
+  >::invoke_t;
+
+  // Is invoked with the context as first argument
+  invoke_type invoke;
+  void* context;
+
+  ReturnType operator()(Args... args) const {
+    return invoke(context, std::forward<Args>(args)...);
+  }
 };
 
 // Performs no operation on the given pointer.
@@ -418,7 +577,7 @@ inline void function_wrapper_noop2(void* /*dest*/, void* /*dest*/) { }
 
 // Constructs a type T at the given destination with the given arguments.
 template<typename T, typename... Args>
-static void function_wrapper_construct(void* destination, Args... args) {
+static void function_wrapper_construct(void* destination, Args&&... args) {
   new (destination) typename std::decay<T>::type(std::forward<Args>(args)...);
 }
 
@@ -429,17 +588,6 @@ static void function_wrapper_destruct(void* destination) {
   (void)destination;
 }
 
-// Returns the required size of the type to allocate in-place.
-template<typename T>
-static std::size_t function_wrapper_required_size() {
-  return required_capacity_to_allocate_inplace<T>::value;
-}
-
-// Returns a zero size.
-inline std::size_t function_wrapper_zero_size() {
-  return 0UL;
-}
-
 // Moves the given type at the target location to another one.
 template<typename T>
 static void function_wrapper_move(void* from, void* to) {
@@ -452,6 +600,107 @@ static void function_wrapper_copy(void* from, void* to) {
   function_wrapper_construct<T>(to, *static_cast<T*>(from));
 }
 
+// Returns the move operation of the type T
+template<typename T>
+constexpr function_type_ops::move_t
+move_operation_of(std::true_type /*is_move_constructible*/) {
+  return function_wrapper_move<T>;
+}
+
+// Returns no move operation for types which aren't move constructible,
+// those are always allocated on the heap and never moved.
+template<typename T>
+constexpr function_type_ops::move_t
+move_operation_of(std::false_type /*is_move_constructible*/) {
+  return nullptr;
+}
+
+// Frees the given heap allocation unless it was released,
+// which cleans up when the constructor of a functor throws.
+class allocation_guard {
+  void* _pointer;
+
+public:
+  explicit allocation_guard(void* pointer) : _pointer(pointer) { }
+  allocation_guard(allocation_guard const&) = delete;
+  allocation_guard& operator= (allocation_guard const&) = delete;
+  ~allocation_guard() {
+    std::free(_pointer);
+  }
+
+  void* get() const {
+    return _pointer;
+  }
+
+  void* release() {
+    void* const pointer = _pointer;
+    _pointer = nullptr;
+    return pointer;
+  }
+};
+
+// The type operations of an empty function,
+// a template to provide a definition inside every translation unit.
+template<typename = void>
+struct type_ops_of_empty_function {
+  static constexpr function_type_ops const value {
+    function_wrapper_noop,
+    function_wrapper_noop2,
+    function_wrapper_noop2,
+    0UL,
+    1UL,
+    &type_id_tag<void>::id,
+    true
+  };
+};
+
+#if __cplusplus < 201703L
+template<typename Unused>
+constexpr function_type_ops const type_ops_of_empty_function<Unused>::value;
+#endif
+
+// Is a true type if the functor T is relocatable by copying its bytes,
+// which is specialized for functors defined by the library.
+template<typename T>
+struct is_trivially_relocatable_functor
+  : std::integral_constant<bool, fu2::is_trivially_relocatable<T>::value> { };
+
+// The type operations of the type T which are shared
+// between all functions with the same copyability.
+template<typename T, bool Copyable>
+struct type_ops_of_type {
+  static constexpr function_type_ops const value {
+    function_wrapper_destruct<T>,
+    move_operation_of<T>(std::is_move_constructible<T>{}),
+    function_wrapper_copy<T>,
+    required_capacity_to_allocate_inplace<T>::value,
+    std::alignment_of<T>::value,
+    &type_id_tag<T>::id,
+    is_trivially_relocatable_functor<T>::value
+  };
+};
+
+template<typename T>
+struct type_ops_of_type<T, false> {
+  static constexpr function_type_ops const value {
+    function_wrapper_destruct<T>,
+    move_operation_of<T>(std::is_move_constructible<T>{}),
+    nullptr,
+    required_capacity_to_allocate_inplace<T>::value,
+    std::alignment_of<T>::value,
+    &type_id_tag<T>::id,
+    is_trivially_relocatable_functor<T>::value
+  };
+};
+
+#if __cplusplus < 201703L
+template<typename T, bool Copyable>
+constexpr function_type_ops const type_ops_of_type<T, Copyable>::value;
+
+template<typename T>
+constexpr function_type_ops const type_ops_of_type<T, false>::value;
+#endif
+
 template<typename /*T*/, typename /*Signature*/, typename /*Qualifier*/>
 struct function_wrapper_invoker;
 
@@ -462,10 +711,13 @@ struct function_wrapper_invoker;
     signature<ReturnType(Args...)>, \
     qualifier<IS_CONST, IS_VOLATILE, IS_RVALUE> \
   > { \
-    static ReturnType invoke(void* target, Args&&... args) { \
-      return FU2_MACRO_MOVE_IF(IS_RVALUE)(* static_cast< \
-        T FU2_MACRO_NO_REF_QUALIFIER(IS_CONST, IS_VOLATILE) *>( \
-          target))(std::forward<Args>(args)...); \
+    static ReturnType invoke(void* target, \
+                             vtable_argument_t<Args>... args) { \
+      /* The cast discards results when the signature returns void */ \
+      return static_cast<ReturnType>( \
+        FU2_MACRO_MOVE_IF(IS_RVALUE)(* static_cast< \
+          T FU2_MACRO_NO_REF_QUALIFIER(IS_CONST, IS_VOLATILE) *>( \
+            target))(std::forward<Args>(args)...)); \
     } \
   };
 
@@ -473,6 +725,60 @@ FU2_MACRO_EXPAND_ALL(FU2_MACRO_DEFINE_CALL_OPERATOR)
 
 #undef FU2_MACRO_DEFINE_CALL_OPERATOR
 
+template<typename /*T*/, typename /*Signature*/, typename /*Qualifier*/>
+struct heap_wrapper_invoker;
+
+// Invokes the heap allocated functor whose pointer
+// is stored inside the given internal capacity.
+template<typename T, typename ReturnType, typename... Args, typename Qualifier>
+struct heap_wrapper_invoker<T, signature<ReturnType(Args...)>, Qualifier> {
+  static ReturnType invoke(void* locale, vtable_argument_t<Args>... args) {
+    return function_wrapper_invoker<
+      T, signature<ReturnType(Args...)>, Qualifier
+    >::invoke(*static_cast<void**>(locale), std::forward<Args>(args)...);
+  }
+};
+
+template<typename /*Invoker*/, typename /*Signature*/>
+struct batch_wrapper_invoker;
+
+// Invokes the given invoker once for every argument of the range,
+// the loop is generated for the concrete functor which allows the compiler
+// to inline and vectorize it behind a single indirect call.
+template<typename Invoker, typename ReturnType, typename Arg>
+struct batch_wrapper_invoker<Invoker, signature<ReturnType(Arg)>> {
+  using traits_t = batch_traits<signature<ReturnType(Arg)>>;
+
+  static void invoke(void* target, typename traits_t::argument_t const* first,
+                     typename traits_t::argument_t const* last,
+                     typename traits_t::result_t* out) {
+    for (; first != last; ++first, ++out)
+      *out = Invoker::invoke(target, static_cast<Arg>(*first));
+  }
+};
+
+// Returns the batched invoke operation of the given invoker
+template<typename Invoker, typename Signature>
+constexpr typename function_vtable<Signature>::invoke_batch_t
+batch_operation_of(std::true_type /*is_invocable*/) {
+  return batch_wrapper_invoker<Invoker, Signature>::invoke;
+}
+
+// Returns no batched invoke operation for signatures which
+// aren't invocable in batches.
+template<typename Invoker, typename Signature>
+constexpr typename function_vtable<Signature>::invoke_batch_t
+batch_operation_of(std::false_type /*is_invocable*/) {
+  return nullptr;
+}
+
+// Is a true type if functions with the given signature and qualifier
+// provide a batched invoke operation.
+template<typename Signature, typename Qualifier>
+using is_batch_invocable = std::integral_constant<bool,
+  batch_traits<Signature>::is_invocable::value && !Qualifier::is_rvalue
+>;
+
 struct bad_function_call : std::exception {
   bad_function_call() { }
 
@@ -487,12 +793,11 @@ struct vtable_creator_of_empty_function;
 template<typename ReturnType, typename... Args>
 struct vtable_creator_of_empty_function<signature<ReturnType(Args...)>, true> {
   using common_vtable_t = function_vtable<
-    signature<ReturnType(Args...)>,
-    true
+    signature<ReturnType(Args...)>
   >;
 
   // Throws an empty function call
-  static ReturnType invoke(void*, Args&&...) {
+  static ReturnType invoke(void*, vtable_argument_t<Args>...) {
 #ifdef FU2_MACRO_DISABLE_EXCEPTIONS
     std::abort();
 #else
@@ -500,97 +805,470 @@ struct vtable_creator_of_empty_function<signature<ReturnType(Args...)>, true> {
 #endif
   }
 
-  static common_vtable_t const* create_vtable() {
-    static constexpr common_vtable_t const vtable(
-      function_wrapper_noop,
-      invoke,
-      function_wrapper_zero_size,
-      function_wrapper_noop2,
-      function_wrapper_noop2
-    );
+  static constexpr common_vtable_t const vtable {
+    invoke,
+    batch_operation_of<
+      vtable_creator_of_empty_function, signature<ReturnType(Args...)>
+    >(typename batch_traits<
+        signature<ReturnType(Args...)>
+      >::is_invocable{}),
+    &type_ops_of_empty_function<>::value,
+    functor_location::none,
+    &vtable_creator_of_empty_function::vtable
+  };
 
+  static constexpr common_vtable_t const* create_vtable() {
     return &vtable;
   }
 };
 
+#if __cplusplus < 201703L
+template<typename ReturnType, typename... Args>
+constexpr typename vtable_creator_of_empty_function<
+  signature<ReturnType(Args...)>, true
+>::common_vtable_t const vtable_creator_of_empty_function<
+  signature<ReturnType(Args...)>, true
+>::vtable;
+#endif
+
 template<typename ReturnType, typename... Args>
 struct vtable_creator_of_empty_function<signature<ReturnType(Args...)>, false> {
   using common_vtable_t = function_vtable<
-    signature<ReturnType(Args...)>,
-    true
+    signature<ReturnType(Args...)>
   >;
 
   // Non-Throwing empty function call
-  static ReturnType invoke(void*, Args&&...) {
+  static ReturnType invoke(void*, vtable_argument_t<Args>...) {
     std::abort();
   }
 
-  static common_vtable_t const* create_vtable() {
-    static constexpr common_vtable_t const vtable(
-      function_wrapper_noop,
-      invoke,
-      function_wrapper_zero_size,
-      function_wrapper_noop2,
-      function_wrapper_noop2
-    );
+  static constexpr common_vtable_t const vtable {
+    invoke,
+    batch_operation_of<
+      vtable_creator_of_empty_function, signature<ReturnType(Args...)>
+    >(typename batch_traits<
+        signature<ReturnType(Args...)>
+      >::is_invocable{}),
+    &type_ops_of_empty_function<>::value,
+    functor_location::none,
+    &vtable_creator_of_empty_function::vtable
+  };
 
+  static constexpr common_vtable_t const* create_vtable() {
     return &vtable;
   }
 };
 
-template<typename /*T*/, typename /*Signature*/,
-         typename /*Qualifier*/, bool /*Copyable*/>
-struct vtable_creator_of_type;
+#if __cplusplus < 201703L
+template<typename ReturnType, typename... Args>
+constexpr typename vtable_creator_of_empty_function<
+  signature<ReturnType(Args...)>, false
+>::common_vtable_t const vtable_creator_of_empty_function<
+  signature<ReturnType(Args...)>, false
+>::vtable;
+#endif
 
-template<typename T, typename ReturnType, typename... Args, typename Qualifier>
-struct vtable_creator_of_type<T, signature<ReturnType(Args...)>,
-                              Qualifier, true> {
-  using common_vtable_t = function_vtable<
-    signature<ReturnType(Args...)>,
-    true
-  >;
+// The vtable of the type T which is stored in-place
+// or on the heap when IsInplace is false.
+template<typename T, typename Signature, typename Qualifier,
+         bool Copyable, bool IsInplace>
+struct vtable_creator_of_type {
+  using common_vtable_t = function_vtable<Signature>;
+
+  static constexpr common_vtable_t const vtable {
+    function_wrapper_invoker<T, Signature, Qualifier>::invoke,
+    batch_operation_of<
+      function_wrapper_invoker<T, Signature, Qualifier>, Signature
+    >(is_batch_invocable<Signature, Qualifier>{}),
+    &type_ops_of_type<T, Copyable>::value,
+    functor_location::inplace,
+    &vtable_creator_of_type<T, Signature, Qualifier, Copyable, false>::vtable
+  };
+
+  static constexpr common_vtable_t const* create_vtable() {
+    return &vtable;
+  }
+};
 
-  static common_vtable_t const* create_vtable() {
-    static common_vtable_t const vtable(
-      function_wrapper_destruct<T>,
-      function_wrapper_invoker<
-        T, signature<ReturnType(Args...)>, Qualifier
-      >::invoke,
-      function_wrapper_required_size<T>,
-      function_wrapper_move<T>,
-      function_wrapper_copy<T>
-    );
+template<typename T, typename Signature, typename Qualifier, bool Copyable>
+struct vtable_creator_of_type<T, Signature, Qualifier, Copyable, false> {
+  using common_vtable_t = function_vtable<Signature>;
+
+  static constexpr common_vtable_t const vtable {
+    heap_wrapper_invoker<T, Signature, Qualifier>::invoke,
+    batch_operation_of<
+      heap_wrapper_invoker<T, Signature, Qualifier>, Signature
+    >(is_batch_invocable<Signature, Qualifier>{}),
+    &type_ops_of_type<T, Copyable>::value,
+    functor_location::heap,
+    &vtable_creator_of_type::vtable
+  };
 
+  static constexpr common_vtable_t const* create_vtable() {
     return &vtable;
   }
 };
 
+#if __cplusplus < 201703L
+template<typename T, typename Signature, typename Qualifier,
+         bool Copyable, bool IsInplace>
+constexpr typename vtable_creator_of_type<
+  T, Signature, Qualifier, Copyable, IsInplace
+>::common_vtable_t const vtable_creator_of_type<
+  T, Signature, Qualifier, Copyable, IsInplace
+>::vtable;
+
+template<typename T, typename Signature, typename Qualifier, bool Copyable>
+constexpr typename vtable_creator_of_type<
+  T, Signature, Qualifier, Copyable, false
+>::common_vtable_t const vtable_creator_of_type<
+  T, Signature, Qualifier, Copyable, false
+>::vtable;
+#endif
+
+// Returns the offset of a functor with the given alignment inside the heap
+// block of a compact function, which starts with the vtable pointer.
+constexpr std::size_t compact_block_offset(std::size_t alignment) {
+  return ((sizeof(void*) + alignment - 1) / alignment) * alignment;
+}
+
+template<typename /*T*/, typename /*Signature*/, typename /*Qualifier*/>
+struct compact_wrapper_invoker;
+
+// Invokes the functor of the given compact heap block, the offset of
+// the functor is known at compile-time here.
 template<typename T, typename ReturnType, typename... Args, typename Qualifier>
-struct vtable_creator_of_type<T, signature<ReturnType(Args...)>,
-                              Qualifier, false> {
-  using common_vtable_t = function_vtable<
-    signature<ReturnType(Args...)>,
-    true
-  >;
+struct compact_wrapper_invoker<T, signature<ReturnType(Args...)>, Qualifier> {
+  static ReturnType invoke(void* block, vtable_argument_t<Args>... args) {
+    return function_wrapper_invoker<
+      T, signature<ReturnType(Args...)>, Qualifier
+    >::invoke(static_cast<char*>(block) +
+                compact_block_offset(std::alignment_of<T>::value),
+              std::forward<Args>(args)...);
+  }
+};
 
-  static common_vtable_t const* create_vtable() {
-    static common_vtable_t const vtable(
-      function_wrapper_destruct<T>,
-      function_wrapper_invoker<
-        T, signature<ReturnType(Args...)>, Qualifier
-      >::invoke,
-      function_wrapper_required_size<T>,
-      function_wrapper_move<T>,
-      nullptr
-    );
+// The vtable of the type T which is stored inside the heap block of
+// a compact function, its invoke operation is called with the block.
+template<typename T, typename Signature, typename Qualifier, bool Copyable>
+struct vtable_creator_of_compact_type {
+  using common_vtable_t = function_vtable<Signature>;
+
+  static constexpr common_vtable_t const vtable {
+    compact_wrapper_invoker<T, Signature, Qualifier>::invoke,
+    batch_operation_of<
+      compact_wrapper_invoker<T, Signature, Qualifier>, Signature
+    >(is_batch_invocable<Signature, Qualifier>{}),
+    &type_ops_of_type<T, Copyable>::value,
+    functor_location::heap,
+    &vtable_creator_of_compact_type::vtable
+  };
 
+  static constexpr common_vtable_t const* create_vtable() {
     return &vtable;
   }
 };
 
+#if __cplusplus < 201703L
+template<typename T, typename Signature, typename Qualifier, bool Copyable>
+constexpr typename vtable_creator_of_compact_type<
+  T, Signature, Qualifier, Copyable
+>::common_vtable_t const vtable_creator_of_compact_type<
+  T, Signature, Qualifier, Copyable
+>::vtable;
+#endif
+
+// The internal capacity of a function which is used in small functor
+// optimization. It is a union which always provides a slot for
+// function pointers, so the capacity doesn't need to be touched
+// when the function is constant initialized, and a slot for the
+// pointer to heap allocated functors.
+//
+// The capacity is pointer aligned, so it isn't padded behind the vtable
+// pointer. Functors which require a stricter alignment are heap allocated.
+template<std::size_t Capacity, typename FunctionPointer>
+union internal_capacity {
+  constexpr internal_capacity() : function_pointer(nullptr) { }
+  constexpr explicit internal_capacity(FunctionPointer function_pointer_)
+    : function_pointer(function_pointer_) { }
+
+  FunctionPointer function_pointer;
+  void* pointer;
+  typename std::aligned_storage<
+    Capacity, std::alignment_of<void*>::value
+  >::type capacity;
+};
+
+template<typename FunctionPointer>
+union internal_capacity<0UL, FunctionPointer> {
+  constexpr internal_capacity() : function_pointer(nullptr) { }
+  constexpr explicit internal_capacity(FunctionPointer function_pointer_)
+    : function_pointer(function_pointer_) { }
+
+  FunctionPointer function_pointer;
+  void* pointer;
+};
+
+// Is a true type if the qualifier of a function is assignable
+// from a function with the right qualifier.
+template<typename LeftQualifier, typename RightQualifier>
+using is_qualifier_correct = std::integral_constant<bool,
+  (!LeftQualifier::is_const || RightQualifier::is_const) &&
+  (LeftQualifier::is_volatile == RightQualifier::is_volatile) &&
+  (LeftQualifier::is_rvalue || !RightQualifier::is_rvalue)
+>;
+
+// Is a true type if a function with the left signature and qualifier
+// can adopt the target of a function with another right signature.
+template<typename /*LeftSignature*/, typename /*LeftQualifier*/,
+         typename /*RightSignature*/, typename /*RightQualifier*/,
+         typename = always_void_t<>>
+struct is_adoptable : std::false_type { };
+
+template<typename ReturnType, typename... Args, typename LeftQualifier,
+         typename RightReturnType, typename... RightArgs,
+         typename RightQualifier>
+struct is_adoptable<signature<ReturnType(Args...)>, LeftQualifier,
+                    signature<RightReturnType(RightArgs...)>, RightQualifier,
+  always_void_t<
+    typename std::enable_if<is_convertible<
+      decltype(std::declval<
+        typename function_vtable<signature<RightReturnType(RightArgs...)>>
+          ::invoke_t
+      >()(nullptr, std::declval<Args>()...)),
+      ReturnType
+    >::value>::type>>
+  : std::integral_constant<bool,
+      is_qualifier_correct<LeftQualifier, RightQualifier>::value &&
+      !(std::is_same<ReturnType(Args...),
+                     RightReturnType(RightArgs...)>::value &&
+        std::is_same<LeftQualifier, RightQualifier>::value)
+    > { };
+
+// Functor which adopts the target of a function with another signature,
+// the target is invoked through the heap vtable of the original function
+// which avoids to nest both functions into each other.
+template<typename /*RightSignature*/>
+class adopted_function;
+
+template<typename RightReturnType, typename... RightArgs>
+class adopted_function<signature<RightReturnType(RightArgs...)>> {
+  using vtable_ptr_t = function_vtable<
+    signature<RightReturnType(RightArgs...)>
+  > const*;
+
+  vtable_ptr_t _vtable;
+
+  // The heap allocated target which is owned by this functor
+  void* _impl;
+
+public:
+  adopted_function(vtable_ptr_t vtable, void* impl)
+    : _vtable(vtable), _impl(impl) { }
+
+  adopted_function(adopted_function const& right)
+    : _vtable(right._vtable), _impl(nullptr) {
+    allocation_guard guard(std::malloc(_vtable->ops->size));
+    _vtable->ops->copy(right._impl, guard.get());
+    _impl = guard.release();
+  }
+
+  adopted_function(adopted_function&& right) noexcept
+    : _vtable(right._vtable), _impl(right._impl) {
+    right._impl = nullptr;
+  }
+
+  adopted_function& operator= (adopted_function const&) = delete;
+  adopted_function& operator= (adopted_function&&) = delete;
+
+  ~adopted_function() {
+    if (_impl) {
+      _vtable->ops->destruct(_impl);
+      std::free(_impl);
+    }
+  }
+
+  // The qualifier of the right function is applied through its vtable
+  template<typename... Args>
+  auto operator() (Args&&... args) const volatile
+    -> decltype(std::declval<vtable_ptr_t>()->invoke(
+         nullptr, std::forward<Args>(args)...)) {
+    return _vtable->invoke(const_cast<void**>(&_impl),
+                           std::forward<Args>(args)...);
+  }
+};
+
+// Adopted functions only hold the vtable and the pointer to their
+// heap allocated target, thus they are relocatable by copying.
+template<typename RightSignature>
+struct is_trivially_relocatable_functor<adopted_function<RightSignature>>
+  : std::true_type { };
+
+// Functor which adopts the in-place target of a function with another
+// signature, the target is stored behind the vtable of the original
+// function inside the capacity of the adopting function.
+template<typename /*RightSignature*/, std::size_t /*Capacity*/>
+class inplace_adopted_function;
+
+template<typename RightReturnType, typename... RightArgs, std::size_t Capacity>
+class inplace_adopted_function<signature<RightReturnType(RightArgs...)>,
+                               Capacity> {
+  using vtable_ptr_t = function_vtable<
+    signature<RightReturnType(RightArgs...)>
+  > const*;
+
+  using capacity_t = typename std::aligned_storage<
+    Capacity, std::alignment_of<void*>::value
+  >::type;
+
+  // The in-place vtable of the original function
+  vtable_ptr_t _vtable;
+
+  capacity_t _capacity;
+
+public:
+  // Constructs the target from the given one through its move
+  // or copy operation.
+  inplace_adopted_function(vtable_ptr_t vtable, void* target,
+                           function_type_ops::move_t operation)
+    : _vtable(vtable) {
+    operation(target, &_capacity);
+  }
+
+  inplace_adopted_function(inplace_adopted_function const& right)
+    : _vtable(right._vtable) {
+    _vtable->ops->copy(const_cast<capacity_t*>(&right._capacity), &_capacity);
+  }
+
+  // In-place targets are nothrow move constructible
+  inplace_adopted_function(inplace_adopted_function&& right) noexcept
+    : _vtable(right._vtable) {
+    _vtable->ops->move(&right._capacity, &_capacity);
+  }
+
+  inplace_adopted_function& operator= (inplace_adopted_function const&)
+    = delete;
+  inplace_adopted_function& operator= (inplace_adopted_function&&) = delete;
+
+  ~inplace_adopted_function() {
+    _vtable->ops->destruct(&_capacity);
+  }
+
+  // The qualifier of the right function is applied through its vtable
+  template<typename... Args>
+  auto operator() (Args&&... args) const volatile
+    -> decltype(std::declval<vtable_ptr_t>()->invoke(
+         nullptr, std::forward<Args>(args)...)) {
+    return _vtable->invoke(const_cast<capacity_t*>(&_capacity),
+                           std::forward<Args>(args)...);
+  }
+};
+
+// Invokes the second stage with the result of the first stage
+template<typename First, typename Second, typename... Args>
+auto invoke_composed(First&& first, Second&& second, Args&&... args)
+  -> decltype(std::forward<Second>(second)(
+       std::forward<First>(first)(std::forward<Args>(args)...))) {
+  return std::forward<Second>(second)(
+    std::forward<First>(first)(std::forward<Args>(args)...));
+}
+
+// Invokes the second stage without arguments when the first one returns void
+template<typename First, typename Second, typename... Args>
+auto invoke_composed(First&& first, Second&& second, Args&&... args)
+  -> typename std::enable_if<
+       std::is_void<decltype(std::forward<First>(first)(
+         std::forward<Args>(args)...))>::value,
+       decltype(std::forward<Second>(second)())
+     >::type {
+  std::forward<First>(first)(std::forward<Args>(args)...);
+  return std::forward<Second>(second)();
+}
+
+// Functor which passes the result of the first stage to the second one.
+//
+// Chaining compositions nests them into each other by value, so a chain
+// of stages is a single object which is invoked through a single
+// trampoline when it is stored inside a function.
+template<typename First, typename Second>
+class composition {
+  First _first;
+  Second _second;
+
+public:
+  template<typename F, typename S>
+  composition(F&& first, S&& second)
+    : _first(std::forward<F>(first)), _second(std::forward<S>(second)) { }
+
+  template<typename... Args>
+  auto operator() (Args&&... args) &
+    -> decltype(invoke_composed(std::declval<First&>(),
+                                std::declval<Second&>(),
+                                std::forward<Args>(args)...)) {
+    return invoke_composed(_first, _second, std::forward<Args>(args)...);
+  }
+
+  template<typename... Args>
+  auto operator() (Args&&... args) const&
+    -> decltype(invoke_composed(std::declval<First const&>(),
+                                std::declval<Second const&>(),
+                                std::forward<Args>(args)...)) {
+    return invoke_composed(_first, _second, std::forward<Args>(args)...);
+  }
+
+  template<typename... Args>
+  auto operator() (Args&&... args) &&
+    -> decltype(invoke_composed(std::declval<First&&>(),
+                                std::declval<Second&&>(),
+                                std::forward<Args>(args)...)) {
+    return invoke_composed(std::move(_first), std::move(_second),
+                           std::forward<Args>(args)...);
+  }
+
+  /// Appends the given stage, which is invoked with the result of this one
+  template<typename T>
+  composition<composition, typename std::decay<T>::type>
+  then(T&& continuation) && {
+    return {std::move(*this), std::forward<T>(continuation)};
+  }
+
+  /// Appends the given stage to a copy of this composition
+  template<typename T>
+  composition<composition, typename std::decay<T>::type>
+  then(T&& continuation) const& {
+    return {*this, std::forward<T>(continuation)};
+  }
+};
+
+// The composition of the given stages
+template<typename... /*Stages*/>
+struct composition_of;
+
+template<typename First>
+struct composition_of<First> {
+  using type = First;
+};
+
+template<typename First, typename Second, typename... Rest>
+struct composition_of<First, Second, Rest...>
+  : composition_of<composition<First, Second>, Rest...> { };
+
+#if __cplusplus >= 201703L
+template<typename T>
+using in_place_type_t = std::in_place_type_t<T>;
+#else
+/// Tags the construction of a functor of the type T in-place
+template<typename T>
+struct in_place_type_t {
+  explicit in_place_type_t() = default;
+};
+#endif
+
 struct initialize_functor_tag { };
 struct copy_assign_storage_tag { };
 struct move_assign_storage_tag { };
+struct copy_adopt_storage_tag { };
+struct move_adopt_storage_tag { };
 
 template<typename /*Signature*/, typename /*Qualifier*/, typename /*Config*/>
 struct storage_t;
@@ -599,28 +1277,63 @@ template<typename ReturnType, typename... Args,
          typename Qualifier, typename Config>
 struct storage_t<signature<ReturnType(Args...)>, Qualifier, Config> {
   using vtable_ptr_t = function_vtable<
-    signature<ReturnType(Args...)>,
-    Config::is_copyable
+    signature<ReturnType(Args...)>
   > const*;
 
-  vtable_ptr_t _vtable;
+  using function_pointer_t = ReturnType(*)(Args...);
 
-  void* _impl;
+  using empty_vtable_creator_t = vtable_creator_of_empty_function<
+    signature<ReturnType(Args...)>, Config::is_throwing
+  >;
 
-  typename std::conditional<(Config::capacity > 0UL),
-    typename std::aligned_storage<Config::capacity>::type,
-    std::true_type
-  >::type _locale;
+  using internal_capacity_t = internal_capacity<
+    Config::capacity, function_pointer_t
+  >;
 
-  storage_t() {
-    tidy();
-  }
+  // The capacity which is usable for in-place allocation, it is at least
+  // pointer sized because of the slot for function pointers. Thus function
+  // pointers and pointer sized functors, like coroutine handles, are always
+  // allocated in-place.
+  using local_capacity = std::integral_constant<std::size_t,
+    sizeof(internal_capacity_t)
+  >;
+
+  // The alignment which is usable for in-place allocation
+  using local_alignment = std::integral_constant<std::size_t,
+    std::alignment_of<internal_capacity_t>::value
+  >;
+
+  // The internal capacity is placed first, so its address which is passed
+  // to the vtable equals the address of the function.
+  internal_capacity_t _locale;
+
+  // The vtable also describes where the functor is stored, so no pointer
+  // to the functor is required: it is stored in-place inside the internal
+  // capacity or on the heap, then the capacity holds the pointer to it.
+  vtable_ptr_t _vtable;
+
+  constexpr storage_t()
+    : _locale(), _vtable(empty_vtable_creator_t::create_vtable()) { }
+
+  // Stores the function pointer inside its slot of the internal capacity,
+  // null pointers result in an empty function.
+  constexpr explicit storage_t(function_pointer_t function_pointer)
+    : _locale(function_pointer),
+      _vtable(function_pointer
+        ? vtable_creator_of_type<
+            function_pointer_t, signature<ReturnType(Args...)>,
+            Qualifier, Config::is_copyable, true
+          >::create_vtable()
+        : empty_vtable_creator_t::create_vtable()) { }
 
   explicit storage_t(storage_t const& right) {
     weak_copy_assign(right);
   }
 
-  explicit storage_t(storage_t&& right) {
+  // Moves never throw: the right functor is either heap allocated and its
+  // ownership is stolen, or it is nothrow move constructible and fits
+  // into the same capacity.
+  explicit storage_t(storage_t&& right) noexcept {
     weak_move_assign(std::move(right));
   }
 
@@ -629,6 +1342,11 @@ struct storage_t<signature<ReturnType(Args...)>, Qualifier, Config> {
     weak_allocate_object(std::forward<T>(functor));
   }
 
+  template<typename T, typename... CtorArgs>
+  storage_t(in_place_type_t<T>, CtorArgs&&... args) {
+    weak_emplace_object<T>(std::forward<CtorArgs>(args)...);
+  }
+
   template<typename T>
   storage_t(copy_assign_storage_tag, T const& right) {
     weak_copy_assign(right);
@@ -639,72 +1357,135 @@ struct storage_t<signature<ReturnType(Args...)>, Qualifier, Config> {
     weak_move_assign(std::forward<T>(right));
   }
 
+  template<typename T>
+  storage_t(copy_adopt_storage_tag, T const& right) {
+    weak_copy_adopt(right);
+  }
+
+  template<typename T>
+  storage_t(move_adopt_storage_tag, T&& right) {
+    weak_move_adopt(std::forward<T>(right));
+  }
+
+  // The copy is made into a temporary storage first,
+  // so the target is kept when the copy throws.
   storage_t& operator= (storage_t const& right) {
-    weak_deallocate();
-    weak_copy_assign(right);
-    return *this;
+    return *this = storage_t(right);
   }
 
-  storage_t& operator= (storage_t&& right) {
+  storage_t& operator= (storage_t&& right) noexcept {
     weak_deallocate();
     weak_move_assign(std::move(right));
     return *this;
   }
 
-  ~storage_t() {
+  FU2_MACRO_CONSTEXPR_DESTRUCTOR ~storage_t() {
     weak_deallocate();
   }
 
-  // Private API
-  void weak_deallocate() {
-    _vtable->destruct(_impl);
+  // Is a true type if every functor which is stored in-place inside a
+  // storage with the right config also fits into this internal capacity.
+  template<typename RightConfig>
+  using is_always_local_allocatable_from = std::integral_constant<bool,
+    (storage_t<signature<ReturnType(Args...)>, Qualifier, RightConfig>
+       ::local_capacity::value <= local_capacity::value) &&
+    (storage_t<signature<ReturnType(Args...)>, Qualifier, RightConfig>
+       ::local_alignment::value <= local_alignment::value)
+  >;
 
-    if (_impl != &_locale)
-      std::free(_impl);
+  // Returns true when a functor of the given size and alignment
+  // is allocatable inside the internal capacity.
+  static constexpr bool is_local_allocatable(std::size_t size,
+                                             std::size_t alignment) {
+    return (size <= local_capacity::value) &&
+           (alignment <= local_alignment::value);
   }
 
-  // Private API
-  void deallocate() {
-    weak_deallocate();
-    tidy();
+  function_type_ops const* type_ops() const {
+    return _vtable->ops;
+  }
+
+  // Returns true when the storage is relocatable by copying its bytes,
+  // the address of the internal capacity is passed to the vtable on every
+  // call, thus only functors stored in-place need to be relocatable.
+  bool is_trivially_relocatable() const {
+    return (_vtable->location != functor_location::inplace) ||
+           _vtable->ops->is_trivially_relocatable;
+  }
+
+  // Returns the address of the functor
+  void* address() const {
+    return (_vtable->location == functor_location::heap)
+      ? _locale.pointer
+      : const_cast<internal_capacity_t*>(&_locale);
+  }
+
+  // Private API
+  void weak_deallocate() {
+    if (_vtable->location == functor_location::heap) {
+      _vtable->ops->destruct(_locale.pointer);
+      std::free(_locale.pointer);
+    }
+    else {
+      _vtable->ops->destruct(&_locale);
+    }
+  }
+
+  // Private API
+  void deallocate() {
+    weak_deallocate();
+    tidy();
   }
 
   void tidy() {
-    _vtable = vtable_creator_of_empty_function<
-      signature<ReturnType(Args...)>, Config::is_throwing
-    >::create_vtable();
-    _impl = nullptr;
+    _vtable = empty_vtable_creator_t::create_vtable();
   }
 
   // Allocate in locale capacity.
-  template<typename /*T*/>
-  void allocate_space(std::true_type /*is_local_allocateable*/) {
-    _impl = &_locale;
+  template<typename T, typename... CtorArgs>
+  void allocate_object(std::true_type /*is_local_allocateable*/,
+                       CtorArgs&&... args) {
+    function_wrapper_construct<T>(&_locale, std::forward<CtorArgs>(args)...);
+
+    _vtable = vtable_creator_of_type<
+      T, signature<ReturnType(Args...)>, Qualifier, Config::is_copyable, true
+    >::create_vtable();
   }
 
   // Allocate on the heap.
-  template<typename T>
-  void allocate_space(std::false_type /*is_local_allocateable*/) {
-    _impl = std::malloc(sizeof(T));
+  template<typename T, typename... CtorArgs>
+  void allocate_object(std::false_type /*is_local_allocateable*/,
+                       CtorArgs&&... args) {
+    allocation_guard guard(std::malloc(sizeof(T)));
+    function_wrapper_construct<T>(guard.get(),
+                                  std::forward<CtorArgs>(args)...);
+    _locale.pointer = guard.release();
+
+    _vtable = vtable_creator_of_type<
+      T, signature<ReturnType(Args...)>, Qualifier, Config::is_copyable, false
+    >::create_vtable();
   }
 
-  template<typename T>
-  void weak_allocate_object(T functor) {
+  // Constructs the functor of the type T from the given arguments,
+  // the vtable is assigned when the construction succeeded. Functors which
+  // aren't nothrow move constructible are heap allocated, so they are never
+  // moved and moving the function never throws.
+  template<typename T, typename... CtorArgs>
+  void weak_emplace_object(CtorArgs&&... args) {
     using is_local_allocateable = std::integral_constant<bool,
-      required_capacity_to_allocate_inplace<
-        typename std::decay<T>::type
-      >::value <= Config::capacity
+      std::is_nothrow_move_constructible<T>::value &&
+      is_local_allocatable(required_capacity_to_allocate_inplace<T>::value,
+                           std::alignment_of<T>::value)
     >;
 
-    _vtable = vtable_creator_of_type<
-      typename std::decay<T>::type, signature<ReturnType(Args...)>,
-      Qualifier, Config::is_copyable
-    >::create_vtable();
+    allocate_object<T>(is_local_allocateable{},
+                       std::forward<CtorArgs>(args)...);
+  }
 
-    allocate_space<typename std::decay<T>::type>(is_local_allocateable{});
-    function_wrapper_construct<
-      typename std::decay<T>::type
-    >(_impl, std::forward<T>(functor));
+  template<typename T>
+  void weak_allocate_object(T&& functor) {
+    weak_emplace_object<typename std::decay<T>::type>(
+      std::forward<T>(functor));
   }
 
   // Private API
@@ -712,44 +1493,386 @@ struct storage_t<signature<ReturnType(Args...)>, Qualifier, Config> {
            typename std::enable_if<RightConfig::is_copyable>::type* = nullptr>
   void weak_copy_assign(storage_t<signature<ReturnType(Args...)>,
                         Qualifier, RightConfig> const& right) {
-    _vtable = right._vtable;
-
-    auto const required_size = right._vtable->required_size();
-    if (right._impl == &right._locale && (Config::capacity >= required_size))
-      _impl = &_locale;
-    else
-      _impl = std::malloc(required_size);
-
-    right._vtable->copy(right._impl, _impl);
+    auto const vtable = right._vtable;
+    auto const ops = vtable->ops;
+    if ((vtable->location != functor_location::heap) &&
+        (is_always_local_allocatable_from<RightConfig>::value ||
+         is_local_allocatable(ops->size, ops->alignment))) {
+      _vtable = vtable;
+      ops->copy(right.address(), &_locale);
+    }
+    else {
+      allocation_guard guard(std::malloc(ops->size));
+      ops->copy(right.address(), guard.get());
+      _locale.pointer = guard.release();
+      _vtable = vtable->heap_vtable;
+    }
   }
 
   // Private API
   template<typename RightConfig>
   void weak_move_assign(storage_t<signature<ReturnType(Args...)>,
                         Qualifier, RightConfig>&& right) {
-    _vtable = right._vtable;
-
-    auto const required_size = right._vtable->required_size();
-    if (right._impl == &right._locale) {
-      if (Config::capacity >= required_size)
-        _impl = &_locale;
-      else
-        _impl = std::malloc(required_size);
+    auto const vtable = right._vtable;
+    auto const ops = vtable->ops;
+    if (vtable->location == functor_location::heap) {
+      // Steal the ownership
+      _vtable = vtable;
+      _locale.pointer = right._locale.pointer;
+      right.tidy();
+      return;
+    }
 
-      right._vtable->move(right._impl, _impl);
-      right.deallocate();
+    if (is_always_local_allocatable_from<RightConfig>::value ||
+        is_local_allocatable(ops->size, ops->alignment)) {
+      _vtable = vtable;
+      ops->move(&right._locale, &_locale);
     }
     else {
+      _vtable = vtable->heap_vtable;
+      _locale.pointer = std::malloc(ops->size);
+      ops->move(&right._locale, _locale.pointer);
+    }
+
+    // The right functor is known to be in-place
+    ops->destruct(&right._locale);
+    right.tidy();
+  }
+
+  // The capacity which remains for adopted targets
+  // besides the vtable of their original function.
+  using adoptable_capacity = std::integral_constant<std::size_t,
+    (local_capacity::value > sizeof(void*))
+      ? local_capacity::value - sizeof(void*)
+      : 0UL
+  >;
+
+  using is_adoptable_in_place = std::integral_constant<bool,
+    (adoptable_capacity::value > 0UL)
+  >;
+
+  // Adopts the given in-place target of a function with the right
+  // signature into our capacity through its move or copy operation,
+  // returns false when it doesn't fit.
+  template<typename RightSignature>
+  bool weak_adopt_in_place(std::true_type /*is_adoptable_in_place*/,
+                           function_vtable<RightSignature> const* vtable,
+                           void* target, function_type_ops::move_t operation) {
+    if ((vtable->ops->size > adoptable_capacity::value) ||
+        (vtable->ops->alignment > std::alignment_of<void*>::value)) {
+      return false;
+    }
+
+    weak_emplace_object<inplace_adopted_function<
+      RightSignature, adoptable_capacity::value
+    >>(vtable, target, operation);
+    return true;
+  }
+
+  template<typename RightSignature>
+  bool weak_adopt_in_place(std::false_type /*is_adoptable_in_place*/,
+                           function_vtable<RightSignature> const* /*vtable*/,
+                           void* /*target*/,
+                           function_type_ops::move_t /*operation*/) {
+    return false;
+  }
+
+  // Private API
+  template<typename RightSignature, typename RightQualifier,
+           typename RightConfig,
+           typename std::enable_if<RightConfig::is_copyable>::type* = nullptr>
+  void weak_copy_adopt(storage_t<RightSignature,
+                       RightQualifier, RightConfig> const& right) {
+    if (right.empty()) {
+      tidy();
+      return;
+    }
+
+    auto const ops = right._vtable->ops;
+    if ((right._vtable->location == functor_location::inplace) &&
+        weak_adopt_in_place<RightSignature>(
+          is_adoptable_in_place{}, right._vtable,
+          right.address(), ops->copy)) {
+      return;
+    }
+
+    allocation_guard guard(std::malloc(ops->size));
+    ops->copy(right.address(), guard.get());
+    weak_allocate_object(adopted_function<RightSignature>(
+      right._vtable->heap_vtable, guard.release()));
+  }
+
+  // Private API
+  template<typename RightSignature, typename RightQualifier,
+           typename RightConfig>
+  void weak_move_adopt(storage_t<RightSignature,
+                       RightQualifier, RightConfig>&& right) {
+    if (right.empty()) {
+      tidy();
+      return;
+    }
+
+    auto const vtable = right._vtable;
+    void* impl;
+    if (vtable->location == functor_location::heap) {
       // Steal the ownership
-      _impl = right._impl;
+      impl = right._locale.pointer;
       right.tidy();
     }
+    else if (weak_adopt_in_place<RightSignature>(
+               is_adoptable_in_place{}, vtable, &right._locale,
+               vtable->ops->move)) {
+      right.deallocate();
+      return;
+    }
+    else {
+      // The target is moved to the heap since it doesn't fit into our
+      // capacity besides the vtable of the right function.
+      impl = std::malloc(vtable->ops->size);
+      vtable->ops->move(&right._locale, impl);
+      right.deallocate();
+    }
+
+    weak_allocate_object(
+      adopted_function<RightSignature>(vtable->heap_vtable, impl));
   }
 
-  bool empty() const { return _impl ? false : true; }
+  bool empty() const {
+    return _vtable->location == functor_location::none;
+  }
+
+  // Invokes the target of the given storage, which is qualified
+  // like the function it belongs to.
+  template<typename Storage, typename... CallArgs>
+  static ReturnType invoke(Storage& storage, CallArgs&&... args) {
+    return storage._vtable->invoke(
+      const_cast<internal_capacity_t*>(&storage._locale),
+      std::forward<CallArgs>(args)...);
+  }
+
+  // Returns the invoke operation of the vtable and its context
+  trampoline<signature<ReturnType(Args...)>> target_trampoline() const {
+    return {_vtable->invoke, const_cast<internal_capacity_t*>(&_locale)};
+  }
+
+  // Invokes the target once for every argument of the given range
+  template<typename Argument, typename Result>
+  void invoke_batch(Argument const* first, Argument const* last,
+                    Result* out) const {
+    _vtable->invoke_batch(const_cast<internal_capacity_t*>(&_locale),
+                          first, last, out);
+  }
 
 }; // struct storage_t
 
+template<typename /*Signature*/, typename /*Qualifier*/, typename /*Config*/>
+struct compact_storage_t;
+
+// The storage of a compact function, which is a single pointer to a heap
+// block that starts with the vtable pointer and is followed by the functor.
+//
+// Empty functions hold a null pointer, moves never touch the functor.
+template<typename ReturnType, typename... Args,
+         typename Qualifier, typename Config>
+struct compact_storage_t<signature<ReturnType(Args...)>, Qualifier, Config> {
+  using vtable_ptr_t = function_vtable<
+    signature<ReturnType(Args...)>
+  > const*;
+
+  using function_pointer_t = ReturnType(*)(Args...);
+
+  using empty_vtable_creator_t = vtable_creator_of_empty_function<
+    signature<ReturnType(Args...)>, Config::is_throwing
+  >;
+
+  vtable_ptr_t* _block;
+
+  constexpr compact_storage_t() : _block(nullptr) { }
+
+  // Function pointers are allocated like any other functor,
+  // null pointers result in an empty function.
+  explicit compact_storage_t(function_pointer_t function_pointer)
+    : _block(nullptr) {
+    if (function_pointer)
+      weak_allocate_object(function_pointer);
+  }
+
+  explicit compact_storage_t(compact_storage_t const& right) {
+    weak_copy_assign(right);
+  }
+
+  explicit compact_storage_t(compact_storage_t&& right) noexcept {
+    weak_move_assign(std::move(right));
+  }
+
+  template<typename T>
+  compact_storage_t(initialize_functor_tag, T&& functor) {
+    weak_allocate_object(std::forward<T>(functor));
+  }
+
+  template<typename T, typename... CtorArgs>
+  compact_storage_t(in_place_type_t<T>, CtorArgs&&... args) {
+    weak_emplace_object<T>(std::forward<CtorArgs>(args)...);
+  }
+
+  template<typename T>
+  compact_storage_t(copy_assign_storage_tag, T const& right) {
+    weak_copy_assign(right);
+  }
+
+  template<typename T>
+  compact_storage_t(move_assign_storage_tag, T&& right) {
+    weak_move_assign(std::forward<T>(right));
+  }
+
+  // The copy is made into a temporary storage first,
+  // so the target is kept when the copy throws.
+  compact_storage_t& operator= (compact_storage_t const& right) {
+    return *this = compact_storage_t(right);
+  }
+
+  compact_storage_t& operator= (compact_storage_t&& right) noexcept {
+    weak_deallocate();
+    weak_move_assign(std::move(right));
+    return *this;
+  }
+
+  ~compact_storage_t() {
+    weak_deallocate();
+  }
+
+  // Returns the functor which is stored inside the given block
+  static void* functor_of(vtable_ptr_t* block) {
+    return reinterpret_cast<char*>(block) +
+      compact_block_offset((*block)->ops->alignment);
+  }
+
+  // Private API
+  void weak_deallocate() {
+    if (_block) {
+      (*_block)->ops->destruct(functor_of(_block));
+      std::free(_block);
+    }
+  }
+
+  // Private API
+  void deallocate() {
+    weak_deallocate();
+    tidy();
+  }
+
+  void tidy() {
+    _block = nullptr;
+  }
+
+  // Constructs the functor of the type T from the given arguments,
+  // the block is assigned when the construction succeeded.
+  template<typename T, typename... CtorArgs>
+  void weak_emplace_object(CtorArgs&&... args) {
+    auto const offset = compact_block_offset(std::alignment_of<T>::value);
+
+    allocation_guard guard(std::malloc(offset + sizeof(T)));
+    function_wrapper_construct<T>(static_cast<char*>(guard.get()) + offset,
+                                  std::forward<CtorArgs>(args)...);
+
+    _block = static_cast<vtable_ptr_t*>(guard.release());
+    new (_block) vtable_ptr_t(vtable_creator_of_compact_type<
+      T, signature<ReturnType(Args...)>,
+      Qualifier, Config::is_copyable
+    >::create_vtable());
+  }
+
+  template<typename T>
+  void weak_allocate_object(T&& functor) {
+    weak_emplace_object<typename std::decay<T>::type>(
+      std::forward<T>(functor));
+  }
+
+  // Private API
+  template<typename RightConfig,
+           typename std::enable_if<RightConfig::is_copyable>::type* = nullptr>
+  void weak_copy_assign(compact_storage_t<signature<ReturnType(Args...)>,
+                        Qualifier, RightConfig> const& right) {
+    if (!right._block) {
+      tidy();
+      return;
+    }
+
+    auto const vtable = *right._block;
+    auto const offset = compact_block_offset(vtable->ops->alignment);
+
+    allocation_guard guard(std::malloc(offset + vtable->ops->size));
+    vtable->ops->copy(functor_of(right._block),
+                      static_cast<char*>(guard.get()) + offset);
+
+    _block = static_cast<vtable_ptr_t*>(guard.release());
+    new (_block) vtable_ptr_t(vtable);
+  }
+
+  // Private API
+  template<typename RightConfig>
+  void weak_move_assign(compact_storage_t<signature<ReturnType(Args...)>,
+                        Qualifier, RightConfig>&& right) {
+    // Steal the ownership
+    _block = right._block;
+    right.tidy();
+  }
+
+  bool empty() const { return _block ? false : true; }
+
+  function_type_ops const* type_ops() const {
+    return _block ? (*_block)->ops : &type_ops_of_empty_function<>::value;
+  }
+
+  // The storage only holds the pointer to the heap block
+  bool is_trivially_relocatable() const {
+    return true;
+  }
+
+  // Returns the address of the functor
+  void* address() const {
+    return _block ? functor_of(_block) : nullptr;
+  }
+
+  // Invokes the target of the given storage, which is qualified
+  // like the function it belongs to.
+  template<typename Storage, typename... CallArgs>
+  static ReturnType invoke(Storage& storage, CallArgs&&... args) {
+    vtable_ptr_t* const block = storage._block;
+    if (FU2_MACRO_EXPECT(!block, 0))
+      return empty_vtable_creator_t::invoke(nullptr,
+                                            std::forward<CallArgs>(args)...);
+
+    return (*block)->invoke(block, std::forward<CallArgs>(args)...);
+  }
+
+  // Returns the invoke operation of the vtable and its context
+  trampoline<signature<ReturnType(Args...)>> target_trampoline() const {
+    if (!_block)
+      return {empty_vtable_creator_t::vtable.invoke, nullptr};
+    return {(*_block)->invoke, _block};
+  }
+
+  // Invokes the target once for every argument of the given range
+  template<typename Argument, typename Result>
+  void invoke_batch(Argument const* first, Argument const* last,
+                    Result* out) const {
+    if (FU2_MACRO_EXPECT(!_block, 0))
+      empty_vtable_creator_t::vtable.invoke_batch(nullptr, first, last, out);
+    else
+      (*_block)->invoke_batch(_block, first, last, out);
+  }
+
+}; // struct compact_storage_t
+
+// The storage which is used by functions with the given configuration
+template<typename Signature, typename Qualifier, typename Config>
+using storage_of = typename std::conditional<
+  Config::is_compact,
+  compact_storage_t<Signature, Qualifier, Config>,
+  storage_t<Signature, Qualifier, Config>
+>::type;
+
 template <typename /*Fn*/>
 struct call_operator;
 
@@ -767,8 +1890,9 @@ struct call_operator;
       auto const me = static_cast< \
         base FU2_MACRO_NO_REF_QUALIFIER(IS_CONST, IS_VOLATILE) *>(this); \
       \
-      return me->_storage._vtable->invoke( \
-        me->_storage._impl, std::forward<Args>(args)...); \
+      return Config::instrumentation::template invoke< \
+        ReturnType, typename base::storage_type \
+      >(me->_storage, std::forward<Args>(args)...); \
     } \
   };
 
@@ -798,20 +1922,49 @@ class function<signature<ReturnType(Args...)>, Qualifier, Config>
   // SFINAE helper to filter not invocable parameters T.
   template<typename T>
   using invocation_acceptor_t = typename invocation_acceptor<
-    T, ReturnType(Args...), Qualifier, Config
+    typename std::decay<T>::type, ReturnType(Args...), Qualifier, Config
   >::type;
 
+  // Is a true type if the given function stores its target alike this.
+  template<typename RightConfig>
+  using is_layout_correct_to_this = std::integral_constant<bool,
+    Config::is_compact == RightConfig::is_compact
+  >;
+
+  // Is a true type if the target of the given function is adoptable,
+  // which isn't supported by compact functions.
+  template<typename RightSignature, typename RightQualifier,
+           typename RightConfig>
+  using is_adoptable_to_this = std::integral_constant<bool,
+    is_adoptable<signature<ReturnType(Args...)>, Qualifier,
+                 RightSignature, RightQualifier>::value &&
+    !Config::is_compact && !RightConfig::is_compact
+  >;
+
+  using storage_type = storage_of<
+    signature<ReturnType(Args...)>, Qualifier, Config
+  >;
+
+  // The argument and result types of batched invocations
+  using batch_argument_t = typename batch_traits<
+    signature<ReturnType(Args...)>
+  >::argument_t;
+  using batch_result_t = typename batch_traits<
+    signature<ReturnType(Args...)>
+  >::result_t;
+
   // Implementation storage
-  storage_t<signature<ReturnType(Args...)>, Qualifier, Config> _storage;
+  storage_type _storage;
 
 public:
   /// Default constructor which constructs the function empty
-  function() = default;
+  constexpr function() = default;
 
   /// Copy construction from another copyable function
   template<typename RightConfig,
            typename std::enable_if<
             is_copyable_correct_to_this<RightConfig::is_copyable>::value &&
+            is_layout_correct_to_this<RightConfig>::value &&
             RightConfig::is_copyable
            >::type* = nullptr>
   function(function<signature<ReturnType(Args...)>,
@@ -821,37 +1974,84 @@ public:
   /// Move construction from another function
   template<typename RightConfig,
            typename std::enable_if<
-            is_copyable_correct_to_this<RightConfig::is_copyable>::value
+            is_copyable_correct_to_this<RightConfig::is_copyable>::value &&
+            is_layout_correct_to_this<RightConfig>::value
            >::type* = nullptr>
   function(function<signature<ReturnType(Args...)>,
                               Qualifier, RightConfig>&& right)
     : _storage(move_assign_storage_tag{}, std::move(right._storage)) { }
 
-  /// Construction from a functional object which overloads the `()` operator
+  /// Copy construction from another copyable function with a different
+  /// but compatible signature or qualifier, which adopts a copy of its target.
+  template<typename RightSignature, typename RightQualifier,
+           typename RightConfig,
+           typename std::enable_if<
+            is_adoptable_to_this<RightSignature, RightQualifier,
+                                 RightConfig>::value &&
+            RightConfig::is_copyable
+           >::type* = nullptr>
+  function(function<RightSignature, RightQualifier, RightConfig> const& right)
+    : _storage(copy_adopt_storage_tag{}, right._storage) { }
+
+  /// Move construction from another function with a different
+  /// but compatible signature or qualifier, which adopts its target.
+  template<typename RightSignature, typename RightQualifier,
+           typename RightConfig,
+           typename std::enable_if<
+            is_adoptable_to_this<RightSignature, RightQualifier,
+                                 RightConfig>::value &&
+            is_copyable_correct_to_this<RightConfig::is_copyable>::value
+           >::type* = nullptr>
+  function(function<RightSignature, RightQualifier, RightConfig>&& right)
+    : _storage(move_adopt_storage_tag{}, std::move(right._storage)) { }
+
+  /// Construction from a functional object which overloads the `()` operator,
+  /// the functor is copied or moved exactly once into the function.
   template<typename T,
            typename Acceptor = invocation_acceptor_t<T>>
-  function(T functor)
+  function(T&& functor)
     : _storage(initialize_functor_tag{},
                Acceptor::wrap(std::forward<T>(functor))) { }
 
+  /// Constructs a functor of the type T in-place from the given arguments,
+  /// without an intermediate temporary. The functor isn't required to be
+  /// move constructible when the function isn't copyable.
+  template<typename T, typename... CtorArgs,
+           typename = invocation_acceptor_t<T>>
+  explicit function(in_place_type_t<T> tag, CtorArgs&&... args)
+    : _storage(tag, std::forward<CtorArgs>(args)...) { }
+
+  /// Constructs the function from a pointer to a function with the exact
+  /// signature, a null pointer constructs the function empty.
+  ///
+  /// Functions constructed from a function pointer, a nullptr and
+  /// default constructed functions are constant initializable.
+  constexpr function(ReturnType (*function_pointer)(Args...))
+    : _storage(function_pointer) { }
+
   /// Empty constructs the function
-  explicit function(std::nullptr_t)
+  constexpr explicit function(std::nullptr_t)
     : _storage() { }
 
   /// Copy assigning from another copyable function
   template<typename RightConfig,
-           typename std::enable_if<RightConfig::is_copyable>::type* = nullptr>
+           typename std::enable_if<
+            is_layout_correct_to_this<RightConfig>::value &&
+            RightConfig::is_copyable
+           >::type* = nullptr>
   function& operator= (function<signature<ReturnType(Args...)>,
                                           Qualifier, RightConfig> const& right) {
-    _storage.weak_deallocate();
-    _storage.weak_copy_assign(right._storage);
+    // The copy is made into a temporary storage first,
+    // so the target is kept when the copy throws.
+    _storage = storage_type(copy_assign_storage_tag{}, right._storage);
     return *this;
   }
 
   /// Move assigning from another function
   template<typename RightConfig,
            typename std::enable_if<
-            is_copyable_correct_to_this<RightConfig::is_copyable>::value
+            is_copyable_correct_to_this<RightConfig::is_copyable>::value &&
+            is_layout_correct_to_this<RightConfig>::value
            >::type* = nullptr>
   function& operator= (function<signature<ReturnType(Args...)>,
                                           Qualifier, RightConfig>&& right) {
@@ -860,15 +2060,63 @@ public:
     return *this;
   }
 
-  /// Move assigning from a functional object
+  /// Copy assigning from another copyable function with a different
+  /// but compatible signature or qualifier.
+  template<typename RightSignature, typename RightQualifier,
+           typename RightConfig,
+           typename std::enable_if<
+            is_adoptable_to_this<RightSignature, RightQualifier,
+                                 RightConfig>::value &&
+            RightConfig::is_copyable
+           >::type* = nullptr>
+  function& operator= (function<RightSignature,
+                                RightQualifier, RightConfig> const& right) {
+    // The copy is adopted into a temporary storage first,
+    // so the target is kept when the copy throws.
+    _storage = storage_type(copy_adopt_storage_tag{}, right._storage);
+    return *this;
+  }
+
+  /// Move assigning from another function with a different
+  /// but compatible signature or qualifier.
+  template<typename RightSignature, typename RightQualifier,
+           typename RightConfig,
+           typename std::enable_if<
+            is_adoptable_to_this<RightSignature, RightQualifier,
+                                 RightConfig>::value &&
+            is_copyable_correct_to_this<RightConfig::is_copyable>::value
+           >::type* = nullptr>
+  function& operator= (function<RightSignature,
+                                RightQualifier, RightConfig>&& right) {
+    _storage.weak_deallocate();
+    _storage.weak_move_adopt(std::move(right._storage));
+    return *this;
+  }
+
+  /// Assigning from a functional object, the functor is copied or moved
+  /// exactly once into a temporary storage which is moved into the function
+  /// afterwards. Thus the functor may be owned by the current target,
+  /// for instance a target which replaces itself through one of its members.
   template<typename T,
            typename Acceptor = invocation_acceptor_t<T>>
-  function& operator= (T functor) {
-    _storage.weak_deallocate();
-    _storage.weak_allocate_object(Acceptor::wrap(std::forward<T>(functor)));
+  function& operator= (T&& functor) {
+    _storage = storage_type(initialize_functor_tag{},
+                            Acceptor::wrap(std::forward<T>(functor)));
     return *this;
   }
 
+  /// Replaces the target through a functor of the type T which is
+  /// constructed in-place from the given arguments, and returns it.
+  ///
+  /// The function is empty when the constructor of the functor throws.
+  template<typename T, typename... CtorArgs,
+           typename = invocation_acceptor_t<T>>
+  T& emplace(CtorArgs&&... args) {
+    _storage.deallocate();
+    _storage.template weak_emplace_object<T>(std::forward<CtorArgs>(args)...);
+    return *static_cast<T*>(_storage.address());
+  }
+
   /// Clears the function
   function& operator= (std::nullptr_t) {
     _storage.deallocate();
@@ -881,6 +2129,123 @@ public:
   /// Returns true when the function isn't empty
   explicit operator bool() const { return !empty(); }
 
+  /// Returns the identifier of the stored functor type, which equals
+  /// `fu2::type_id_of<void>()` when the function is empty.
+  type_id target_type_id() const {
+    return type_id(_storage.type_ops()->type_id);
+  }
+
+  /// Returns true when the function is relocatable by copying its bytes
+  /// through `fu2::relocate`, which is the case when it is empty, or its
+  /// target is heap allocated or trivially relocatable.
+  bool is_trivially_relocatable() const {
+    return _storage.is_trivially_relocatable();
+  }
+
+  /// Returns true when the function stores a functor of the type T
+  template<typename T>
+  bool holds() const {
+    return target_type_id() == type_id(&type_id_tag<T>::id);
+  }
+
+  /// Returns a pointer to the stored functor when it is of the type T,
+  /// a null pointer otherwise.
+  template<typename T>
+  T* target() {
+    return holds<T>() ? static_cast<T*>(_storage.address()) : nullptr;
+  }
+
+  /// Returns a pointer to the stored functor when it is of the type T,
+  /// a null pointer otherwise.
+  template<typename T>
+  T const* target() const {
+    return holds<T>() ? static_cast<T const*>(_storage.address()) : nullptr;
+  }
+
+  /// Invokes the stored functor as the type T without an indirect call,
+  /// which allows the compiler to inline it. This is undefined behaviour
+  /// when the function doesn't hold a functor of the type T:
+  /// ```
+  /// if (fn.holds<HotHandler>())
+  ///   fn.invoke_as<HotHandler>(event);
+  /// else
+  ///   fn(event);
+  /// ```
+  template<typename T>
+  ReturnType invoke_as(Args... args) {
+    return function_wrapper_invoker<
+      T, signature<ReturnType(Args...)>, Qualifier
+    >::invoke(_storage.address(), std::forward<Args>(args)...);
+  }
+
+  /// Invokes the stored functor as the type T without an indirect call,
+  /// which is only available for const qualified signatures.
+  template<typename T, bool IsConst = Qualifier::is_const,
+           typename std::enable_if<IsConst>::type* = nullptr>
+  ReturnType invoke_as(Args... args) const {
+    return function_wrapper_invoker<
+      T, signature<ReturnType(Args...)>, Qualifier
+    >::invoke(_storage.address(), std::forward<Args>(args)...);
+  }
+
+  /// Returns the target as a raw function pointer and context pair,
+  /// which invokes the target when the function pointer is called with
+  /// the context as first argument. Thus targets are passable to C APIs
+  /// which accept a `R(*)(void*, Args...)` callback plus a context pointer,
+  /// and hot loops can hoist the pair out of the loop:
+  /// ```
+  /// auto const callback = fn.target_trampoline();
+  /// register_callback(callback.invoke, callback.context);
+  /// ```
+  /// Arguments which aren't scalars are passed by reference.
+  /// The pair stays valid until the function is destroyed,
+  /// assigned or moved from, it invokes the target like the function
+  /// which throws when the function was empty.
+  trampoline<signature<ReturnType(Args...)>> target_trampoline() {
+    return _storage.target_trampoline();
+  }
+
+  /// Returns the target as a raw function pointer and context pair,
+  /// which is only available for const qualified signatures.
+  template<bool IsConst = Qualifier::is_const,
+           typename std::enable_if<IsConst>::type* = nullptr>
+  trampoline<signature<ReturnType(Args...)>> target_trampoline() const {
+    return _storage.target_trampoline();
+  }
+
+  /// Invokes the target once for every argument inside the range
+  /// [first, last) and stores the results starting at out.
+  ///
+  /// The range is processed by a loop around the concrete functor behind
+  /// a single indirect call, which allows the compiler to inline and
+  /// vectorize the functor. It is available for signatures with a single
+  /// argument that is passed by value or const reference and a result
+  /// which is returned by value:
+  /// ```
+  /// fu2::function<float(float)> gain = [=](float x) { return x * factor; };
+  /// gain.invoke_batch(input.data(), input.data() + input.size(),
+  ///                   output.data());
+  /// ```
+  template<bool IsBatchInvocable = is_batch_invocable<
+             signature<ReturnType(Args...)>, Qualifier>::value,
+           typename std::enable_if<IsBatchInvocable>::type* = nullptr>
+  void invoke_batch(batch_argument_t const* first,
+                    batch_argument_t const* last, batch_result_t* out) {
+    _storage.invoke_batch(first, last, out);
+  }
+
+  /// Invokes the target once for every argument inside the range
+  /// [first, last), which is only available for const qualified signatures.
+  template<bool IsBatchInvocable = is_batch_invocable<
+             signature<ReturnType(Args...)>, Qualifier>::value &&
+             Qualifier::is_const,
+           typename std::enable_if<IsBatchInvocable>::type* = nullptr>
+  void invoke_batch(batch_argument_t const* first,
+                    batch_argument_t const* last,
+                    batch_result_t* out) const {
+    _storage.invoke_batch(first, last, out);
+  }
+
   /// Assigns a new target, note that the allocator
   /// is ignored like in the common standard library implementations.
   template<typename T, typename Alloc,
@@ -904,6 +2269,16 @@ public:
     left.swap(right);
   }
 
+  /// Returns a composition which invokes the given continuation with the
+  /// result of this function. The function and its continuations are fused
+  /// into a single functor, which is invoked through a single trampoline
+  /// when it is stored inside a function with a sufficient capacity.
+  template<typename T>
+  composition<function, typename std::decay<T>::type>
+  then(T&& continuation) && {
+    return {std::move(*this), std::forward<T>(continuation)};
+  }
+
   /// Calls the function target, returns the result when the function exists
   /// otherwise it throws a fu2::bad_function_call when exceptions are enabled.
   /// When exceptions are disabled std::abort is called.
@@ -939,6 +2314,41 @@ bool operator!= (std::nullptr_t, function<signature<ReturnType(Args...)>,
   return bool(f);
 }
 
+// Relocates the given functions, the ranges may overlap
+template<typename Function>
+Function* relocate(Function* first, Function* last,
+                   Function* destination) noexcept {
+  std::size_t const count = static_cast<std::size_t>(last - first);
+  if (first == destination)
+    return destination + count;
+
+  bool is_trivially_relocatable = true;
+  for (Function const* current = first; current != last; ++current) {
+    if (!current->is_trivially_relocatable()) {
+      is_trivially_relocatable = false;
+      break;
+    }
+  }
+
+  if (is_trivially_relocatable) {
+    std::memmove(static_cast<void*>(destination),
+                 static_cast<void const*>(first), count * sizeof(Function));
+  }
+  else if (std::less<Function*>()(destination, first)) {
+    for (std::size_t i = 0UL; i != count; ++i) {
+      new (destination + i) Function(std::move(first[i]));
+      first[i].~Function();
+    }
+  }
+  else {
+    for (std::size_t i = count; i != 0UL; --i) {
+      new (destination + i - 1UL) Function(std::move(first[i - 1UL]));
+      first[i - 1UL].~Function();
+    }
+  }
+  return destination + count;
+}
+
 // Internal size of an empty function object
 using empty_size = std::integral_constant<std::size_t,
   sizeof(function<
@@ -949,9 +2359,10 @@ using empty_size = std::integral_constant<std::size_t,
 
 // Default capacity for small functor optimization
 using default_capacity = std::integral_constant<std::size_t,
-  // Aim to size the function object to 32UL
+  // Aim to size the function object to 32UL, the pointer sized slot
+  // of an empty function is part of the capacity.
   (empty_size::value < 32UL)
-    ? (32UL - empty_size::value)
+    ? (32UL - empty_size::value + sizeof(void*))
     : 16UL
 >;
 
@@ -972,11 +2383,15 @@ template<
   bool Throwing = true,
   /// Defines whether the function allows assignments from a
   /// function with less arguments.
-  bool PartialApplyable = false>
+  bool PartialApplyable = false,
+  /// Defines the policy which wraps every invocation of the function,
+  /// see `function2/instrumentation.hpp`.
+  typename Instrumentation = detail::no_instrumentation>
 using function_base = detail::function<
   typename detail::unwrap<Signature>::signature,
   typename detail::unwrap<Signature>::qualifier,
-  detail::config<Copyable, Capacity, Throwing, PartialApplyable>
+  detail::config<Copyable, Capacity, Throwing, PartialApplyable, false,
+                 Instrumentation>
 >;
 
 /// Copyable function wrapper for arbitrary functional types.
@@ -993,6 +2408,129 @@ using unique_function = function_base<
   false
 >;
 
+/// Pointer sized function wrapper base for arbitrary functional types.
+///
+/// The functor is always allocated on the heap, inside a single block
+/// which starts with the vtable pointer. Thus the function is a single
+/// pointer which is null when the function is empty, this reduces the
+/// memory of large amounts of rarely invoked functions, like handlers
+/// which are stored per connection or per timer.
+template<
+  /// Defines the signature of the function wrapper
+  typename Signature,
+  /// Defines whether the function is copyable or not
+  bool Copyable,
+  /// Defines whether the function throws an exception on empty function call,
+  /// `std::abort` is called otherwise.
+  bool Throwing = true>
+using compact_function_base = detail::function<
+  typename detail::unwrap<Signature>::signature,
+  typename detail::unwrap<Signature>::qualifier,
+  detail::config<Copyable, 0UL, Throwing, false, true>
+>;
+
+/// Pointer sized copyable function wrapper for arbitrary functional types.
+template<typename Signature>
+using compact_function = compact_function_base<
+  Signature,
+  true
+>;
+
+/// Pointer sized non copyable function wrapper for arbitrary functional types.
+template<typename Signature>
+using compact_unique_function = compact_function_base<
+  Signature,
+  false
+>;
+
+/// Non copyable function wrapper which stores a functor of the type T
+/// in-place, for instance a chain of fused stages created through
+/// `fu2::compose` or `then`. Functors whose move constructor isn't
+/// noexcept are heap allocated like inside any other function.
+template<typename Signature, typename T>
+using fused_function = function_base<
+  Signature,
+  false,
+  detail::required_capacity_to_allocate_inplace<T>::value
+>;
+
+/// Returns the given functor.
+template<typename First>
+typename std::decay<First>::type compose(First&& first) {
+  return std::forward<First>(first);
+}
+
+/// Composes the given functors into a single functor, which passes
+/// the result of every functor to the next one.
+template<typename First, typename Second, typename... Rest>
+typename detail::composition_of<
+  typename std::decay<First>::type,
+  typename std::decay<Second>::type,
+  typename std::decay<Rest>::type...
+>::type
+compose(First&& first, Second&& second, Rest&&... rest) {
+  return fu2::compose(
+    detail::composition<
+      typename std::decay<First>::type,
+      typename std::decay<Second>::type
+    >(std::forward<First>(first), std::forward<Second>(second)),
+    std::forward<Rest>(rest)...);
+}
+
+/// Tags the construction of a functor of the type T in-place,
+/// which is `std::in_place_type_t` since C++17.
+using detail::in_place_type_t;
+
+/// A raw function pointer and context pair which invokes the target
+/// of a function, see `function::target_trampoline()`.
+template<typename Signature>
+using trampoline = detail::trampoline<
+  typename detail::unwrap<Signature>::signature
+>;
+
+/// The instrumentation policy of functions which aren't instrumented
+using detail::no_instrumentation;
+
+/// Is specialized as true type for functors which are relocatable by
+/// copying their bytes to another address without destroying the source,
+/// for instance functors which don't point into themselves:
+/// ```
+/// namespace fu2 {
+/// template<>
+/// struct is_trivially_relocatable<my_handler> : std::true_type { };
+/// }
+/// ```
+/// It is true for scalars such as function pointers by default.
+template<typename T>
+struct is_trivially_relocatable : std::is_scalar<T> { };
+
+/// Relocates the functions inside the range [first, last) into the
+/// uninitialized storage starting at destination and returns the end of
+/// the relocated range. The source range is left uninitialized afterwards,
+/// thus its functions must not be destroyed. The ranges may overlap,
+/// so containers are able to shift their elements on insert and erase.
+///
+/// The functions are copied through a single `std::memmove` when all
+/// of them are relocatable as described by
+/// `function::is_trivially_relocatable`, otherwise every function is moved
+/// to its destination and destroyed.
+template<typename Signature, typename Qualifier, typename Config,
+         typename Function = detail::function<Signature, Qualifier, Config>>
+Function* relocate(detail::function<Signature, Qualifier, Config>* first,
+                   Function* last, Function* destination) noexcept {
+  return detail::relocate(first, last, destination);
+}
+
+/// Identifies the type of a functor without RTTI
+using detail::type_id;
+
+/// Returns the identifier of the type T, which is comparable to
+/// the `target_type_id()` of functions.
+template<typename T>
+constexpr type_id type_id_of() {
+  return type_id(&detail::type_id_tag<T>::id);
+}
+
 /// Exception type when invoking empty functional wrappers.
 ///
 /// The exception type thrown through empty function calls
@@ -1001,8 +2539,68 @@ using detail::bad_function_call;
 
 } /// namespace fu2
 
+// Names the function wrapper with the given configuration,
+// alias templates can't be used inside explicit instantiations.
+#define FU2_DETAIL_FUNCTION_TYPE(COPYABLE, CAPACITY, THROWING, ...) \
+  ::fu2::detail::function< \
+    ::fu2::detail::unwrap<__VA_ARGS__>::signature, \
+    ::fu2::detail::unwrap<__VA_ARGS__>::qualifier, \
+    ::fu2::detail::config<COPYABLE, CAPACITY, THROWING, false>>
+
+// Declares (PREFIX = extern) or defines (PREFIX empty) the explicit
+// instantiation of every signature dependent part of a function wrapper.
+#define FU2_DETAIL_EXPLICIT_INSTANTIATION(PREFIX, COPYABLE, CAPACITY, \
+                                          THROWING, ...) \
+  PREFIX template class FU2_DETAIL_FUNCTION_TYPE( \
+    COPYABLE, CAPACITY, THROWING, __VA_ARGS__); \
+  PREFIX template struct ::fu2::detail::call_operator< \
+    FU2_DETAIL_FUNCTION_TYPE(COPYABLE, CAPACITY, THROWING, __VA_ARGS__)>;
+
+/// Suppresses the implicit instantiation of `fu2::function_base`
+/// with the given signature inside the current translation unit.
+///
+/// Pair it with exactly one FU2_INSTANTIATE_FUNCTION_BASE
+/// of the same arguments inside the program, for instance:
+/// ```
+/// // callbacks.hpp
+/// FU2_EXTERN_TEMPLATE_FUNCTION_BASE(true, 64, true, void(int, float))
+/// // callbacks.cpp
+/// FU2_INSTANTIATE_FUNCTION_BASE(true, 64, true, void(int, float))
+/// ```
+#define FU2_EXTERN_TEMPLATE_FUNCTION_BASE(COPYABLE, CAPACITY, THROWING, ...) \
+  FU2_DETAIL_EXPLICIT_INSTANTIATION(extern, COPYABLE, CAPACITY, \
+                                    THROWING, __VA_ARGS__)
+
+/// Explicitly instantiates `fu2::function_base` with the given signature.
+#define FU2_INSTANTIATE_FUNCTION_BASE(COPYABLE, CAPACITY, THROWING, ...) \
+  FU2_DETAIL_EXPLICIT_INSTANTIATION(, COPYABLE, CAPACITY, \
+                                    THROWING, __VA_ARGS__)
+
+/// Suppresses the implicit instantiation of
+/// `fu2::function` with the given signature.
+#define FU2_EXTERN_TEMPLATE_FUNCTION(...) \
+  FU2_EXTERN_TEMPLATE_FUNCTION_BASE(true, \
+    ::fu2::detail::default_capacity::value, true, __VA_ARGS__)
+
+/// Explicitly instantiates `fu2::function` with the given signature.
+#define FU2_INSTANTIATE_FUNCTION(...) \
+  FU2_INSTANTIATE_FUNCTION_BASE(true, \
+    ::fu2::detail::default_capacity::value, true, __VA_ARGS__)
+
+/// Suppresses the implicit instantiation of
+/// `fu2::unique_function` with the given signature.
+#define FU2_EXTERN_TEMPLATE_UNIQUE_FUNCTION(...) \
+  FU2_EXTERN_TEMPLATE_FUNCTION_BASE(false, \
+    ::fu2::detail::default_capacity::value, true, __VA_ARGS__)
+
+/// Explicitly instantiates `fu2::unique_function` with the given signature.
+#define FU2_INSTANTIATE_UNIQUE_FUNCTION(...) \
+  FU2_INSTANTIATE_FUNCTION_BASE(false, \
+    ::fu2::detail::default_capacity::value, true, __VA_ARGS__)
+
 #undef FU2_MACRO_DISABLE_EXCEPTIONS
 #undef FU2_MACRO_EXPECT
+#undef FU2_MACRO_CONSTEXPR_DESTRUCTOR
 #undef FU2_MACRO_IF
 #undef FU2_MACRO_IF_true
 #undef FU2_MACRO_IF_false
@@ -0,0 +1,668 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef FU2_INCLUDED_FUTURE_HPP__
+#define FU2_INCLUDED_FUTURE_HPP__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <type_traits>
+#include "function2/function2.hpp"
+
+namespace fu2 {
+template<typename T>
+class promise;
+template<typename T>
+class future;
+
+namespace detail {
+inline namespace v4 {
+namespace futures {
+
+// The flags of the state word, the remaining bits count the references
+// which are held by the promise and the future.
+enum : std::size_t {
+  // The promise was fulfilled or broken
+  state_completed = 1UL,
+  // The promise was destroyed without being fulfilled
+  state_broken = 2UL,
+  // The future attached a continuation
+  state_continued = 4UL,
+  // The future waits for the promise to complete
+  state_waiting = 8UL,
+  state_reference = 16UL
+};
+
+// The count of times a waiting future checks the state
+// before it blocks.
+constexpr std::size_t spin_count() {
+  return 64UL;
+}
+
+#if !defined(__cpp_lib_atomic_wait) || (__cpp_lib_atomic_wait < 201907L)
+// A condition which waiting futures block on, the slots are shared
+// between the states whose addresses hash to them.
+struct parking_slot {
+  std::mutex mutex;
+  std::condition_variable condition;
+};
+
+constexpr std::size_t parking_slot_count() {
+  return 64UL;
+}
+
+// Returns the slot of the given state, the slots are created
+// when a future blocks for the first time.
+inline parking_slot& parking_slot_of(void const* state) {
+  static parking_slot slots[parking_slot_count()];
+  return slots[(reinterpret_cast<std::uintptr_t>(state) >> 4U) %
+               parking_slot_count()];
+}
+#endif
+
+// Stores the value which is passed to the continuation
+template<typename T>
+class value_storage {
+  typename std::aligned_storage<sizeof(T), alignof(T)>::type storage_;
+
+public:
+  template<typename... Args>
+  void emplace(Args&&... args) {
+    new (&storage_) T(std::forward<Args>(args)...);
+  }
+
+  void destroy() {
+    get().~T();
+  }
+
+  T& get() {
+    return *reinterpret_cast<T*>(&storage_);
+  }
+};
+
+template<>
+class value_storage<void> {
+public:
+  void emplace() { }
+  void destroy() { }
+  void get() { }
+};
+
+// The signature of the continuation
+template<typename T>
+struct continuation_signature {
+  using type = void(T);
+};
+
+template<>
+struct continuation_signature<void> {
+  using type = void();
+};
+
+// The state which is shared between a promise and its future.
+//
+// The value and the continuation are published through a single state
+// word: whichever side completes its half last invokes the continuation,
+// and whichever side releases its reference last destroys the state.
+template<typename T>
+class shared_state {
+  using continuation_t =
+    unique_function<typename continuation_signature<T>::type>;
+
+  std::atomic<std::size_t> state_;
+  value_storage<T> value_;
+  continuation_t continuation_;
+
+  template<typename U = T>
+  typename std::enable_if<!std::is_void<U>::value>::type continue_now() {
+    continuation_(std::move(value_.get()));
+  }
+  template<typename U = T>
+  typename std::enable_if<std::is_void<U>::value>::type continue_now() {
+    continuation_();
+  }
+
+  // Marks the promise as completed, wakes the waiting future up and
+  // invokes the continuation when it was attached already.
+  void complete(std::size_t flags) {
+    std::size_t const previous =
+      state_.fetch_or(flags, std::memory_order_acq_rel);
+    if (previous & state_waiting)
+      wake();
+    if ((previous & state_continued) && !(flags & state_broken))
+      continue_now();
+  }
+
+#if defined(__cpp_lib_atomic_wait) && (__cpp_lib_atomic_wait >= 201907L)
+  // Blocks until the promise completed and returns the state
+  std::size_t park() {
+    std::size_t state =
+      state_.fetch_or(state_waiting, std::memory_order_acq_rel) |
+      state_waiting;
+    while (!(state & state_completed)) {
+      state_.wait(state, std::memory_order_acquire);
+      state = state_.load(std::memory_order_acquire);
+    }
+    return state;
+  }
+
+  void wake() {
+    state_.notify_all();
+  }
+#else
+  // Blocks until the promise completed and returns the state. The waiting
+  // flag is set while holding the lock of the slot, so the promise either
+  // observes it and notifies after the future blocked, or the future
+  // observes the completion.
+  std::size_t park() {
+    parking_slot& slot = parking_slot_of(this);
+    std::unique_lock<std::mutex> lock(slot.mutex);
+    std::size_t state =
+      state_.fetch_or(state_waiting, std::memory_order_acq_rel);
+    while (!(state & state_completed)) {
+      slot.condition.wait(lock);
+      state = state_.load(std::memory_order_acquire);
+    }
+    return state;
+  }
+
+  void wake() {
+    parking_slot& slot = parking_slot_of(this);
+    {
+      std::lock_guard<std::mutex> const lock(slot.mutex);
+    }
+    slot.condition.notify_all();
+  }
+#endif
+
+public:
+  shared_state() : state_(2UL * state_reference) { }
+  shared_state(shared_state const&) = delete;
+  shared_state& operator=(shared_state const&) = delete;
+  ~shared_state() {
+    if ((state_.load(std::memory_order_relaxed) &
+         (state_completed | state_broken)) == state_completed)
+      value_.destroy();
+  }
+
+  template<typename... Args>
+  void set_value(Args&&... args) {
+    value_.emplace(std::forward<Args>(args)...);
+    complete(state_completed);
+  }
+
+  void set_broken() {
+    complete(state_completed | state_broken);
+  }
+
+  // Attaches the continuation, which is invoked immediately
+  // when the promise was fulfilled already.
+  template<typename F>
+  void set_continuation(F&& continuation) {
+    continuation_ = std::forward<F>(continuation);
+    std::size_t const previous =
+      state_.fetch_or(state_continued, std::memory_order_acq_rel);
+    if ((previous & (state_completed | state_broken)) == state_completed)
+      continue_now();
+  }
+
+  bool is_ready() const {
+    return (state_.load(std::memory_order_acquire) & state_completed) != 0UL;
+  }
+
+  // Waits until the promise completed, returns false when it was broken.
+  // The future yields for a few times before it blocks.
+  bool wait() {
+    std::size_t state = state_.load(std::memory_order_acquire);
+    for (std::size_t i = 0UL;
+         !(state & state_completed) && (i < spin_count()); ++i) {
+      std::this_thread::yield();
+      state = state_.load(std::memory_order_acquire);
+    }
+    if (!(state & state_completed))
+      state = park();
+    return !(state & state_broken);
+  }
+
+  value_storage<T>& value() {
+    return value_;
+  }
+
+  // Releases the reference of the promise or the future
+  void release() {
+    if (state_.fetch_sub(state_reference, std::memory_order_acq_rel) <
+        2UL * state_reference) {
+      delete this;
+    }
+  }
+};
+
+// Invokes the callback with the value and fulfills the promise
+// with the result of the callback.
+template<typename R>
+struct fulfill {
+  template<typename F, typename... Args>
+  static void invoke(promise<R>& target, F& callback, Args&&... args) {
+    target.set_value(callback(std::forward<Args>(args)...));
+  }
+};
+
+template<>
+struct fulfill<void> {
+  template<typename Promise, typename F, typename... Args>
+  static void invoke(Promise& target, F& callback, Args&&... args) {
+    callback(std::forward<Args>(args)...);
+    target.set_value();
+  }
+};
+
+// The continuation which is attached by future::then
+template<typename R, typename F>
+class then_continuation {
+  promise<R> promise_;
+  F callback_;
+
+public:
+  then_continuation(promise<R> promise, F callback)
+    : promise_(std::move(promise)), callback_(std::move(callback)) { }
+
+  template<typename... Args>
+  void operator()(Args&&... args) {
+    fulfill<R>::invoke(promise_, callback_, std::forward<Args>(args)...);
+  }
+};
+
+// The result of the callback which is passed to future::then
+template<typename T, typename F>
+struct then_result {
+  using type = decltype(std::declval<F&>()(std::declval<T>()));
+};
+
+template<typename F>
+struct then_result<void, F> {
+  using type = decltype(std::declval<F&>()());
+};
+
+// The state which is shared between the futures passed to when_all
+template<typename T>
+class all_state {
+  // A value which is written once by the continuation of its future
+  struct slot {
+    slot() : is_constructed(false) { }
+
+    value_storage<T> value;
+    bool is_constructed;
+  };
+
+  std::atomic<std::size_t> pending_;
+  std::size_t const size_;
+  std::unique_ptr<slot[]> slots_;
+  promise<std::vector<T>> promise_;
+
+public:
+  all_state(std::size_t size, promise<std::vector<T>> promise)
+    : pending_(size), size_(size), slots_(new slot[size]),
+      promise_(std::move(promise)) { }
+
+  ~all_state() {
+    for (std::size_t i = 0UL; i < size_; ++i) {
+      if (slots_[i].is_constructed)
+        slots_[i].value.destroy();
+    }
+  }
+
+  void set_value(std::size_t index, T value) {
+    slots_[index].value.emplace(std::move(value));
+    slots_[index].is_constructed = true;
+  }
+
+  // Fulfills the promise when every future was fulfilled, after the
+  // continuations of all futures were invoked or destroyed.
+  void release() {
+    if (pending_.fetch_sub(1UL, std::memory_order_acq_rel) != 1UL)
+      return;
+
+    std::vector<T> values;
+    values.reserve(size_);
+    for (std::size_t i = 0UL; i < size_; ++i) {
+      if (!slots_[i].is_constructed)
+        break;
+      values.push_back(std::move(slots_[i].value.get()));
+    }
+    if (values.size() == size_)
+      promise_.set_value(std::move(values));
+    delete this;
+  }
+};
+
+// The state which is shared between the futures passed to when_any
+template<typename T>
+class any_state {
+  std::atomic<std::size_t> pending_;
+  std::atomic<bool> is_fulfilled_;
+  promise<std::pair<std::size_t, T>> promise_;
+
+public:
+  any_state(std::size_t size, promise<std::pair<std::size_t, T>> promise)
+    : pending_(size), is_fulfilled_(false), promise_(std::move(promise)) { }
+
+  void set_value(std::size_t index, T value) {
+    if (!is_fulfilled_.exchange(true, std::memory_order_acq_rel))
+      promise_.set_value(std::make_pair(index, std::move(value)));
+  }
+
+  void release() {
+    if (pending_.fetch_sub(1UL, std::memory_order_acq_rel) == 1UL)
+      delete this;
+  }
+};
+
+// The continuation which is attached to the futures passed to
+// when_all and when_any, it releases the state when it is destroyed
+// regardless of whether it was invoked.
+template<typename State, typename T>
+class aggregate_continuation {
+  State* state_;
+  std::size_t index_;
+
+public:
+  aggregate_continuation(State* state, std::size_t index)
+    : state_(state), index_(index) { }
+  aggregate_continuation(aggregate_continuation&& right) noexcept
+    : state_(right.state_), index_(right.index_) {
+    right.state_ = nullptr;
+  }
+  aggregate_continuation& operator=(aggregate_continuation&&) = delete;
+  ~aggregate_continuation() {
+    if (state_)
+      state_->release();
+  }
+
+  void operator()(T value) {
+    state_->set_value(index_, std::move(value));
+  }
+};
+
+} /// namespace futures
+} /// inline namespace
+} /// namespace detail
+
+/// The producing side of a one-shot channel, which passes a single value
+/// to the continuation or the waiter of its future.
+///
+/// The pair allocates its shared state once, which is synchronized through
+/// a single atomic word instead of a mutex. The continuation is stored
+/// in-place of a `fu2::unique_function` inside the shared state, thus
+/// attaching a small continuation doesn't allocate memory.
+///
+/// When the promise is destroyed without being fulfilled, the continuation
+/// of the future is destroyed without being invoked.
+template<typename T>
+class promise {
+  template<typename>
+  friend class future;
+
+  // The state is kept after the promise was fulfilled until
+  // the future was retrieved.
+  detail::futures::shared_state<T>* state_;
+  bool is_retrieved_;
+  bool is_fulfilled_;
+
+  void reset() {
+    if (!state_)
+      return;
+
+    if (!is_fulfilled_) {
+      state_->set_broken();
+      state_->release();
+    }
+    // Releases the reference of a future which was never retrieved
+    if (!is_retrieved_)
+      state_->release();
+    state_ = nullptr;
+  }
+
+public:
+  /// Allocates the shared state
+  promise()
+    : state_(new detail::futures::shared_state<T>()), is_retrieved_(false),
+      is_fulfilled_(false) { }
+
+  promise(promise&& right) noexcept
+    : state_(right.state_), is_retrieved_(right.is_retrieved_),
+      is_fulfilled_(right.is_fulfilled_) {
+    right.state_ = nullptr;
+  }
+
+  promise& operator=(promise&& right) noexcept {
+    if (this != &right) {
+      reset();
+      state_ = right.state_;
+      is_retrieved_ = right.is_retrieved_;
+      is_fulfilled_ = right.is_fulfilled_;
+      right.state_ = nullptr;
+    }
+    return *this;
+  }
+
+  promise(promise const&) = delete;
+  promise& operator=(promise const&) = delete;
+
+  /// Breaks the promise when it wasn't fulfilled
+  ~promise() {
+    reset();
+  }
+
+  /// Returns the future of the promise, which is retrievable once
+  future<T> get_future() {
+    if (!state_ || is_retrieved_)
+      std::abort();
+
+    is_retrieved_ = true;
+    future<T> result(state_);
+    if (is_fulfilled_)
+      state_ = nullptr;
+    return result;
+  }
+
+  /// Fulfills the promise, the continuation of the future is invoked
+  /// on the calling thread when it was attached already.
+  template<typename... Args>
+  void set_value(Args&&... args) {
+    if (!state_ || is_fulfilled_)
+      std::abort();
+
+    is_fulfilled_ = true;
+    state_->set_value(std::forward<Args>(args)...);
+    state_->release();
+    if (is_retrieved_)
+      state_ = nullptr;
+  }
+};
+
+/// The consuming side of a one-shot channel, see `fu2::promise`.
+///
+/// The value is consumed once, either by a continuation or by waiting
+/// for it, which invalidates the future.
+template<typename T>
+class future {
+  template<typename>
+  friend class promise;
+
+  detail::futures::shared_state<T>* state_;
+
+  explicit future(detail::futures::shared_state<T>* state) : state_(state) { }
+
+  template<typename U = T>
+  static typename std::enable_if<!std::is_void<U>::value, U>::type
+  take(detail::futures::shared_state<T>* state) {
+    return std::move(state->value().get());
+  }
+  template<typename U = T>
+  static typename std::enable_if<std::is_void<U>::value>::type
+  take(detail::futures::shared_state<T>*) { }
+
+  // Releases the shared state after the value was taken
+  class release_guard {
+    detail::futures::shared_state<T>* state_;
+
+  public:
+    explicit release_guard(detail::futures::shared_state<T>* state)
+      : state_(state) { }
+    release_guard(release_guard const&) = delete;
+    release_guard& operator=(release_guard const&) = delete;
+    ~release_guard() {
+      state_->release();
+    }
+  };
+
+public:
+  /// Constructs an invalid future
+  future() : state_(nullptr) { }
+
+  future(future&& right) noexcept : state_(right.state_) {
+    right.state_ = nullptr;
+  }
+
+  future& operator=(future&& right) noexcept {
+    if (this != &right) {
+      if (state_)
+        state_->release();
+      state_ = right.state_;
+      right.state_ = nullptr;
+    }
+    return *this;
+  }
+
+  future(future const&) = delete;
+  future& operator=(future const&) = delete;
+
+  ~future() {
+    if (state_)
+      state_->release();
+  }
+
+  /// Returns true when the future wasn't consumed yet
+  bool valid() const {
+    return state_ != nullptr;
+  }
+
+  /// Returns true when the promise was fulfilled or broken
+  bool is_ready() const {
+    return state_ && state_->is_ready();
+  }
+
+  /// Attaches a continuation which is invoked with the value once
+  /// the promise is fulfilled, and invalidates the future.
+  ///
+  /// The continuation is invoked on the thread which fulfills the promise,
+  /// or immediately when the promise was fulfilled already.
+  template<typename F>
+  void subscribe(F&& continuation) {
+    if (!state_)
+      std::abort();
+
+    detail::futures::shared_state<T>* const state = state_;
+    state_ = nullptr;
+    state->set_continuation(std::forward<F>(continuation));
+    state->release();
+  }
+
+  /// Returns a future of the result of the given callback, which is
+  /// invoked with the value once the promise is fulfilled,
+  /// and invalidates this future.
+  ///
+  /// The returned future is broken when this one is.
+  template<typename F,
+           typename R = typename detail::futures::then_result<
+             T, typename std::decay<F>::type
+           >::type>
+  future<R> then(F&& callback) {
+    promise<R> next;
+    future<R> result = next.get_future();
+    subscribe(detail::futures::then_continuation<
+      R, typename std::decay<F>::type
+    >(std::move(next), std::forward<F>(callback)));
+    return result;
+  }
+
+  /// Waits until the promise is fulfilled and returns the value,
+  /// which invalidates the future. The thread blocks when the promise
+  /// isn't fulfilled shortly.
+  ///
+  /// `std::abort` is called when the promise was broken.
+  T get() {
+    if (!state_ || !state_->wait())
+      std::abort();
+
+    detail::futures::shared_state<T>* const state = state_;
+    state_ = nullptr;
+    // The state is released after the value was moved into the result
+    release_guard const guard(state);
+    return take(state);
+  }
+};
+
+/// Returns a future of the values of all given futures in their order,
+/// which is fulfilled once all futures were fulfilled.
+///
+/// The returned future is broken when any of the futures is broken.
+template<typename T>
+future<std::vector<T>> when_all(std::vector<future<T>> futures) {
+  static_assert(!std::is_void<T>::value,
+                "when_all requires futures of non void values!");
+
+  promise<std::vector<T>> result;
+  future<std::vector<T>> all = result.get_future();
+  if (futures.empty()) {
+    result.set_value();
+    return all;
+  }
+
+  auto state = new detail::futures::all_state<T>(futures.size(),
+                                                 std::move(result));
+  for (std::size_t i = 0UL; i < futures.size(); ++i) {
+    futures[i].subscribe(detail::futures::aggregate_continuation<
+      detail::futures::all_state<T>, T>(state, i));
+  }
+  return all;
+}
+
+/// Returns a future of the index and the value of the first given future
+/// which is fulfilled.
+///
+/// The returned future is broken when all of the futures are broken.
+template<typename T>
+future<std::pair<std::size_t, T>> when_any(std::vector<future<T>> futures) {
+  static_assert(!std::is_void<T>::value,
+                "when_any requires futures of non void values!");
+
+  promise<std::pair<std::size_t, T>> result;
+  future<std::pair<std::size_t, T>> any = result.get_future();
+  if (futures.empty())
+    return any;
+
+  auto state = new detail::futures::any_state<T>(futures.size(),
+                                                 std::move(result));
+  for (std::size_t i = 0UL; i < futures.size(); ++i) {
+    futures[i].subscribe(detail::futures::aggregate_continuation<
+      detail::futures::any_state<T>, T>(state, i));
+  }
+  return any;
+}
+
+} /// namespace fu2
+
+#endif // FU2_INCLUDED_FUTURE_HPP__
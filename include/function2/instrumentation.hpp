@@ -0,0 +1,349 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef FU2_INCLUDED_INSTRUMENTATION_HPP__
+#define FU2_INCLUDED_INSTRUMENTATION_HPP__
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <utility>
+#include <vector>
+#include <type_traits>
+#include "function2/function2.hpp"
+
+namespace fu2 {
+namespace detail {
+inline namespace v4 {
+namespace instrumentation {
+
+// The count of latency buckets, the bucket i counts the samples which
+// took less than 2^i nanoseconds and at least 2^(i - 1) nanoseconds.
+constexpr std::size_t bucket_count() {
+  return 40UL;
+}
+
+// The count of histograms per thread as power of two, samples of further
+// tags and target types are dropped.
+constexpr std::size_t histogram_count() {
+  return 64UL;
+}
+
+// The latencies of a tag and target type which were sampled by a single
+// thread, only the owning thread writes to it.
+struct histogram {
+  histogram() : tag(nullptr), target(nullptr), name(nullptr), samples(0U),
+                nanoseconds(0U) {
+    for (auto& bucket : buckets) {
+      bucket.store(0U, std::memory_order_relaxed);
+    }
+  }
+
+  // The tag is published last, it is null while the histogram is unused
+  std::atomic<void const*> tag;
+  std::atomic<void const*> target;
+  std::atomic<char const*> name;
+  std::atomic<std::uint64_t> samples;
+  std::atomic<std::uint64_t> nanoseconds;
+  std::atomic<std::uint64_t> buckets[bucket_count()];
+};
+
+// The histograms of a single thread, records are never freed
+// and reused by other threads after the owning thread exited.
+struct record {
+  record() : is_used(true), next(nullptr), dropped(0U) { }
+
+  std::atomic<bool> is_used;
+  record* next;
+  // The count of samples which didn't fit into the histograms
+  std::atomic<std::uint64_t> dropped;
+  histogram histograms[histogram_count()];
+};
+
+// Increments a counter which is only written by the owning thread,
+// readers observe either the old or the new value.
+inline void increment(std::atomic<std::uint64_t>& counter,
+                      std::uint64_t value) {
+  counter.store(counter.load(std::memory_order_relaxed) + value,
+                std::memory_order_relaxed);
+}
+
+// Returns the bucket of the given latency
+inline std::size_t bucket_of(std::uint64_t nanoseconds) {
+  std::size_t bucket = 0UL;
+  for (; nanoseconds && (bucket < bucket_count() - 1UL); nanoseconds >>= 1U) {
+    ++bucket;
+  }
+  return bucket;
+}
+
+// The records of all threads which sampled an invocation, a template
+// to provide a definition inside every translation unit.
+template<typename = void>
+struct registry {
+  static std::atomic<record*> records;
+
+  // Acquires a record for the lifetime of the current thread
+  class record_handle {
+    record* record_;
+
+  public:
+    record_handle() : record_(acquire()) { }
+    record_handle(record_handle const&) = delete;
+    record_handle& operator=(record_handle const&) = delete;
+    ~record_handle() {
+      record_->is_used.store(false, std::memory_order_release);
+    }
+
+    record& get() const {
+      return *record_;
+    }
+  };
+
+  static record* acquire() {
+    for (record* current = records.load(std::memory_order_acquire);
+         current; current = current->next) {
+      bool expected = false;
+      if (!current->is_used.load(std::memory_order_relaxed) &&
+          current->is_used.compare_exchange_strong(
+            expected, true, std::memory_order_acquire)) {
+        return current;
+      }
+    }
+
+    record* current = new record();
+    current->next = records.load(std::memory_order_relaxed);
+    while (!records.compare_exchange_weak(current->next, current,
+      std::memory_order_release, std::memory_order_relaxed)) { }
+    return current;
+  }
+
+  static record& local_record() {
+    static thread_local record_handle const handle;
+    return handle.get();
+  }
+
+  // Adds a sample to the histogram of the given tag and target type
+  // of the current thread.
+  static void sample(void const* tag, void const* target, char const* name,
+                     std::uint64_t nanoseconds) {
+    record& local = local_record();
+
+    std::size_t const hash = std::hash<void const*>()(tag) ^
+                             (std::hash<void const*>()(target) * 31UL);
+    for (std::size_t probe = 0UL; probe < histogram_count(); ++probe) {
+      histogram& current =
+        local.histograms[(hash + probe) & (histogram_count() - 1UL)];
+
+      void const* const owner = current.tag.load(std::memory_order_relaxed);
+      if (!owner) {
+        current.target.store(target, std::memory_order_relaxed);
+        current.name.store(name, std::memory_order_relaxed);
+        current.tag.store(tag, std::memory_order_release);
+      }
+      else if ((owner != tag) ||
+               (current.target.load(std::memory_order_relaxed) != target)) {
+        continue;
+      }
+
+      increment(current.samples, 1U);
+      increment(current.nanoseconds, nanoseconds);
+      increment(current.buckets[bucket_of(nanoseconds)], 1U);
+      return;
+    }
+    increment(local.dropped, 1U);
+  }
+};
+
+template<typename T>
+std::atomic<record*> registry<T>::records(nullptr);
+
+// Returns the name of tags which provide a static name method
+template<typename Tag>
+auto name_of(int) -> decltype(Tag::name()) {
+  return Tag::name();
+}
+template<typename Tag>
+char const* name_of(...) {
+  return nullptr;
+}
+
+// Measures the duration of an invocation until it returns or throws
+class sample_guard {
+  void const* tag_;
+  void const* target_;
+  char const* name_;
+  std::chrono::steady_clock::time_point start_;
+
+public:
+  sample_guard(void const* tag, void const* target, char const* name)
+    : tag_(tag), target_(target), name_(name),
+      start_(std::chrono::steady_clock::now()) { }
+  sample_guard(sample_guard const&) = delete;
+  sample_guard& operator=(sample_guard const&) = delete;
+  ~sample_guard() {
+    auto const duration = std::chrono::steady_clock::now() - start_;
+    registry<>::sample(tag_, target_, name_, static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()));
+  }
+};
+
+} /// namespace instrumentation
+} /// inline namespace
+} /// namespace detail
+
+/// An instrumentation policy which measures the latency of every
+/// SampleRate-th invocation of a function on each thread, for instance:
+/// ```
+/// struct parser_tag {
+///   static char const* name() { return "parser"; }
+/// };
+///
+/// fu2::function_base<void(), true, fu2::detail::default_capacity::value,
+///                    true, false, fu2::sampled_instrumentation<parser_tag>>
+///   fn = [] { parse(); };
+/// ```
+///
+/// Samples are recorded into per-thread histograms keyed by the tag and the
+/// type of the stored functor, the histograms are written without any
+/// synchronization besides relaxed atomic stores. Invocations which aren't
+/// sampled only decrement a thread-local counter. Tags may provide a static
+/// `name()` method which is used by `fu2::dump_instrumentation`.
+///
+/// Batched invocations and trampolines bypass the instrumentation.
+template<typename Tag, std::size_t SampleRate = 1024UL>
+struct sampled_instrumentation {
+  static_assert(SampleRate > 0UL, "The sample rate must not be zero!");
+
+  template<typename ReturnType, typename StorageType,
+           typename Storage, typename... CallArgs>
+  static ReturnType invoke(Storage& storage, CallArgs&&... args) {
+    if (--countdown != 0UL) {
+      return StorageType::invoke(storage, std::forward<CallArgs>(args)...);
+    }
+
+    countdown = SampleRate;
+    detail::instrumentation::sample_guard const guard(
+      &detail::type_id_tag<Tag>::id,
+      const_cast<typename std::remove_cv<Storage>::type&>(storage)
+        .type_ops()->type_id,
+      detail::instrumentation::name_of<Tag>(0));
+    return StorageType::invoke(storage, std::forward<CallArgs>(args)...);
+  }
+
+private:
+  static thread_local std::size_t countdown;
+};
+
+template<typename Tag, std::size_t SampleRate>
+thread_local std::size_t
+  sampled_instrumentation<Tag, SampleRate>::countdown = SampleRate;
+
+/// The latencies which were sampled for a tag and target type
+struct instrumentation_histogram {
+  /// The type of the instrumentation tag
+  type_id tag;
+  /// The type of the invoked functor
+  type_id target;
+  /// The name of the tag, or null when it doesn't provide one
+  char const* name;
+  /// The count of sampled invocations
+  std::uint64_t samples;
+  /// The summed latency of all sampled invocations
+  std::uint64_t nanoseconds;
+  /// The bucket i counts the samples which took less than 2^i nanoseconds
+  std::array<std::uint64_t, detail::instrumentation::bucket_count()> buckets;
+
+  /// Returns the upper bound in nanoseconds of the given percentile
+  /// of the sampled latencies, for instance 0.99.
+  std::uint64_t percentile(double fraction) const {
+    std::uint64_t seen = 0U;
+    for (std::size_t i = 0UL; i < buckets.size(); ++i) {
+      seen += buckets[i];
+      if ((seen > 0U) &&
+          (static_cast<double>(seen) >= fraction * static_cast<double>(samples)))
+        return std::uint64_t(1) << i;
+    }
+    return 0U;
+  }
+};
+
+/// Returns the latencies which were sampled by all threads so far,
+/// merged by tag and target type.
+///
+/// The snapshot is taken while other threads keep sampling,
+/// and might miss the samples which are recorded concurrently.
+inline std::vector<instrumentation_histogram> instrumentation_snapshot() {
+  using namespace detail::instrumentation;
+
+  std::vector<instrumentation_histogram> snapshot;
+  for (record* current = registry<>::records.load(std::memory_order_acquire);
+       current; current = current->next) {
+    for (histogram const& source : current->histograms) {
+      void const* const tag = source.tag.load(std::memory_order_acquire);
+      if (!tag)
+        continue;
+
+      type_id const tag_id(tag);
+      type_id const target_id(source.target.load(std::memory_order_relaxed));
+      auto merged = snapshot.begin();
+      for (; merged != snapshot.end(); ++merged) {
+        if ((merged->tag == tag_id) && (merged->target == target_id))
+          break;
+      }
+      if (merged == snapshot.end()) {
+        snapshot.push_back(instrumentation_histogram{
+          tag_id, target_id, source.name.load(std::memory_order_relaxed),
+          0U, 0U, {{}}});
+        merged = snapshot.end() - 1;
+      }
+
+      merged->samples += source.samples.load(std::memory_order_relaxed);
+      merged->nanoseconds += source.nanoseconds.load(std::memory_order_relaxed);
+      for (std::size_t i = 0UL; i < bucket_count(); ++i) {
+        merged->buckets[i] += source.buckets[i].load(std::memory_order_relaxed);
+      }
+    }
+  }
+  return snapshot;
+}
+
+/// Writes a line with the sample count, the mean and the 50th, 99th
+/// and 99.9th percentile latency of every snapshot histogram to the stream.
+///
+/// Target types are numbered in order of appearance per tag,
+/// since their names aren't available without RTTI. Histograms without
+/// any sample, which are observed while their first sample is recorded,
+/// are skipped.
+inline void dump_instrumentation(std::ostream& stream) {
+  auto const snapshot = instrumentation_snapshot();
+  for (auto current = snapshot.begin(); current != snapshot.end(); ++current) {
+    // Histograms are published before their first sample is counted
+    if (current->samples == 0U)
+      continue;
+
+    std::size_t target = 0UL;
+    for (auto previous = snapshot.begin(); previous != current; ++previous) {
+      if (previous->tag == current->tag)
+        ++target;
+    }
+
+    stream << (current->name ? current->name : "<unnamed>") << " (target "
+           << target << "): " << current->samples
+           << " samples, mean " << (current->nanoseconds / current->samples)
+           << "ns, p50 < " << current->percentile(0.5)
+           << "ns, p99 < " << current->percentile(0.99)
+           << "ns, p999 < " << current->percentile(0.999) << "ns\n";
+  }
+}
+
+} /// namespace fu2
+
+#endif // FU2_INCLUDED_INSTRUMENTATION_HPP__
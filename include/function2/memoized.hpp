@@ -0,0 +1,415 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef FU2_INCLUDED_MEMOIZED_HPP__
+#define FU2_INCLUDED_MEMOIZED_HPP__
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <type_traits>
+#include "function2/function2.hpp"
+
+namespace fu2 {
+namespace detail {
+inline namespace v4 {
+namespace memoization {
+
+// Marks an empty slot of the index
+constexpr std::uint32_t no_entry() {
+  return ~std::uint32_t(0);
+}
+
+inline std::size_t combine(std::size_t seed, std::size_t hash) {
+  return seed ^ (hash + 0x9e3779b9UL + (seed << 6) + (seed >> 2));
+}
+
+inline std::size_t hash_of() {
+  return 0UL;
+}
+
+template<typename First, typename... Rest>
+std::size_t hash_of(First const& first, Rest const&... rest) {
+  return combine(std::hash<First>()(first), hash_of(rest...));
+}
+
+// Returns the smallest power of two which is greater or equal to the value
+inline std::size_t round_up_to_power_of_two(std::size_t value) {
+  std::size_t result = 1UL;
+  while (result < value) {
+    result <<= 1U;
+  }
+  return result;
+}
+
+// A bounded cache of results keyed by their arguments.
+//
+// Entries are stored contiguously and evicted in CLOCK order: the hand
+// sweeps over the entries and evicts the first one which wasn't looked up
+// since the hand passed it the last time. The entries are found through
+// an open addressing index with linear probing, which is kept at most half
+// full and doesn't need tombstones since evicted entries are removed
+// through backward shifting.
+template<typename R, typename... Keys>
+class cache {
+  struct entry {
+    template<typename Key, typename Value>
+    entry(std::size_t hash_, Key&& key_, Value&& value_)
+      : hash(hash_), is_referenced(false), is_linked(false),
+        key(std::forward<Key>(key_)), value(std::forward<Value>(value_)) { }
+
+    std::size_t hash;
+    // Is set on every lookup and cleared when the hand passes the entry
+    bool is_referenced;
+    // Is cleared for entries which failed to be replaced
+    bool is_linked;
+    std::tuple<Keys...> key;
+    R value;
+  };
+
+  std::vector<entry> entries_;
+  std::vector<std::uint32_t> index_;
+  std::size_t capacity_;
+  std::size_t hand_;
+
+  std::size_t mask() const {
+    return index_.size() - 1UL;
+  }
+
+  // Removes the given entry from the index
+  void unlink(std::uint32_t victim) {
+    if (!entries_[victim].is_linked) {
+      return;
+    }
+    entries_[victim].is_linked = false;
+
+    std::size_t hole = entries_[victim].hash & mask();
+    while (index_[hole] != victim) {
+      hole = (hole + 1UL) & mask();
+    }
+
+    // Moves every following entry of the probe sequence into the hole,
+    // unless its home slot lies cyclically between the hole and itself.
+    for (std::size_t current = (hole + 1UL) & mask();
+         index_[current] != no_entry(); current = (current + 1UL) & mask()) {
+      std::size_t const home = entries_[index_[current]].hash & mask();
+      bool const is_reachable = (hole <= current)
+        ? ((hole < home) && (home <= current))
+        : ((hole < home) || (home <= current));
+      if (!is_reachable) {
+        index_[hole] = index_[current];
+        hole = current;
+      }
+    }
+    index_[hole] = no_entry();
+  }
+
+  void link(std::uint32_t index) {
+    std::size_t slot = entries_[index].hash & mask();
+    while (index_[slot] != no_entry()) {
+      slot = (slot + 1UL) & mask();
+    }
+    index_[slot] = index;
+    entries_[index].is_linked = true;
+  }
+
+  // Unlinks the entry unless it was replaced successfully, since its key
+  // wouldn't match its hash anymore when replacing its key or value threw.
+  class replacement {
+    cache* owner_;
+    std::uint32_t index_;
+
+  public:
+    replacement(cache& owner, std::uint32_t index)
+      : owner_(&owner), index_(index) { }
+    replacement(replacement const&) = delete;
+    replacement& operator=(replacement const&) = delete;
+    ~replacement() {
+      if (owner_) {
+        owner_->unlink(index_);
+      }
+    }
+
+    void commit() {
+      owner_ = nullptr;
+    }
+  };
+
+  // Returns the entry which is reused for a new result, it is still linked
+  // through its old hash until it was replaced.
+  std::uint32_t evict() {
+    while (entries_[hand_].is_referenced) {
+      entries_[hand_].is_referenced = false;
+      hand_ = (hand_ + 1UL) % capacity_;
+    }
+
+    std::uint32_t const victim = static_cast<std::uint32_t>(hand_);
+    hand_ = (hand_ + 1UL) % capacity_;
+    return victim;
+  }
+
+public:
+  explicit cache(std::size_t capacity)
+    : index_(round_up_to_power_of_two(2UL * (capacity ? capacity : 1UL)),
+             no_entry()),
+      capacity_(capacity ? capacity : 1UL), hand_(0UL) {
+    entries_.reserve(capacity_);
+  }
+
+  // Returns the cached result of the given arguments, or null
+  template<typename... Args>
+  R const* find(std::size_t hash, Args const&... args) {
+    for (std::size_t slot = hash & mask(); index_[slot] != no_entry();
+         slot = (slot + 1UL) & mask()) {
+      entry& current = entries_[index_[slot]];
+      if ((current.hash == hash) && (current.key == std::tie(args...))) {
+        current.is_referenced = true;
+        return &current.value;
+      }
+    }
+    return nullptr;
+  }
+
+  // Caches the result of the given arguments, the result which was
+  // cached already is kept and returned when there is any.
+  template<typename Value, typename... Args>
+  R const& insert(std::size_t hash, Value&& value, Args const&... args) {
+    if (R const* const cached = find(hash, args...))
+      return *cached;
+    return insert_missing(hash, std::forward<Value>(value), args...);
+  }
+
+  // Caches the result of the given arguments without looking them up,
+  // they are required not to be cached already.
+  template<typename Value, typename... Args>
+  R const& insert_missing(std::size_t hash, Value&& value,
+                          Args const&... args) {
+    std::uint32_t index;
+    if (entries_.size() < capacity_) {
+      index = static_cast<std::uint32_t>(entries_.size());
+      entries_.emplace_back(hash, std::tie(args...),
+                            std::forward<Value>(value));
+    } else {
+      index = evict();
+      entry& current = entries_[index];
+      {
+        replacement guard(*this, index);
+        current.key = std::tie(args...);
+        current.value = std::forward<Value>(value);
+        guard.commit();
+      }
+
+      unlink(index);
+      current.hash = hash;
+      current.is_referenced = false;
+    }
+
+    link(index);
+    return entries_[index].value;
+  }
+
+  std::size_t size() const {
+    return entries_.size();
+  }
+
+  std::size_t capacity() const {
+    return capacity_;
+  }
+
+  void clear() {
+    entries_.clear();
+    std::fill(index_.begin(), index_.end(), no_entry());
+    hand_ = 0UL;
+  }
+};
+
+// Keeps the shards of a concurrent cache on different cache lines
+template<typename Cache>
+struct shard {
+  explicit shard(std::size_t capacity) : cache(capacity) { }
+
+  std::mutex mutex;
+  Cache cache;
+  char padding[64];
+};
+
+} /// namespace memoization
+} /// inline namespace
+} /// namespace detail
+
+/// A function wrapper which caches the results of the stored functor
+/// keyed by its arguments, for instance for expensive pure lookups.
+///
+/// The functor is stored like inside a `fu2::unique_function` and invoked
+/// with the arguments as const references, only on a cache miss.
+/// The arguments are required to be hashable through `std::hash` and
+/// equality comparable, and the result is required to be copyable.
+///
+/// The cache is bounded to the given count of entries, which are evicted
+/// in CLOCK order: entries which weren't looked up again since the last
+/// sweep of the clock hand are evicted first. The wrapper isn't synchronized,
+/// see `fu2::concurrent_memoized` for a variant which is invocable
+/// from multiple threads concurrently.
+template<typename Signature,
+         std::size_t Capacity = detail::default_capacity::value>
+class memoized;
+
+template<typename R, typename... Args, std::size_t Capacity>
+class memoized<R(Args...), Capacity> {
+  static_assert(!std::is_void<R>::value,
+                "Functions without a result can't be memoized!");
+
+  using handler_t = function_base<R(Args const&...) const, false, Capacity>;
+  using cache_t = detail::memoization::cache<
+    R, typename std::decay<Args>::type...
+  >;
+
+  handler_t target_;
+  cache_t cache_;
+
+public:
+  /// Stores the given functor and a cache of the given count of results
+  template<typename T,
+           typename std::enable_if<
+            std::is_constructible<handler_t, T&&>::value
+           >::type* = nullptr>
+  explicit memoized(T&& target, std::size_t entries = 1024UL)
+    : target_(std::forward<T>(target)), cache_(entries) { }
+
+  memoized(memoized const&) = delete;
+  memoized& operator=(memoized const&) = delete;
+
+  /// Returns the cached result of the given arguments, the functor is
+  /// invoked and its result is cached when there is none.
+  R operator()(Args const&... args) {
+    std::size_t const hash = detail::memoization::hash_of(args...);
+    if (R const* const cached = cache_.find(hash, args...))
+      return *cached;
+    // The functor never caches its own arguments, which would recurse
+    // infinitely, thus they are still missing.
+    return cache_.insert_missing(hash, target_(args...), args...);
+  }
+
+  /// Returns the count of cached results
+  std::size_t size() const {
+    return cache_.size();
+  }
+
+  /// Returns the maximum count of cached results
+  std::size_t capacity() const {
+    return cache_.capacity();
+  }
+
+  /// Removes all cached results
+  void clear() {
+    cache_.clear();
+  }
+};
+
+/// A memoizing function wrapper which is invocable from multiple threads
+/// concurrently, see `fu2::memoized`.
+///
+/// The results are partitioned by the hash of their arguments into shards,
+/// which are locked separately and only while looking up or inserting
+/// a result. The functor is invoked outside of any lock, thus it might be
+/// invoked concurrently and with the same arguments more than once when
+/// the result isn't cached yet.
+template<typename Signature,
+         std::size_t Capacity = detail::default_capacity::value>
+class concurrent_memoized;
+
+template<typename R, typename... Args, std::size_t Capacity>
+class concurrent_memoized<R(Args...), Capacity> {
+  static_assert(!std::is_void<R>::value,
+                "Functions without a result can't be memoized!");
+
+  using handler_t = function_base<R(Args const&...) const, false, Capacity>;
+  using shard_t = detail::memoization::shard<detail::memoization::cache<
+    R, typename std::decay<Args>::type...
+  >>;
+
+  handler_t target_;
+  std::vector<std::unique_ptr<shard_t>> shards_;
+  unsigned shift_;
+
+  shard_t& shard_of(std::size_t hash) const {
+    // The low bits of the hash select the slot inside the shard, thus the
+    // shard is selected by the high bits of the multiplicatively mixed hash.
+    std::size_t const mixed =
+      hash * static_cast<std::size_t>(UINT64_C(0x9e3779b97f4a7c15));
+    return *shards_[shift_ < (sizeof(std::size_t) * 8U) ? (mixed >> shift_)
+                                                         : 0UL];
+  }
+
+public:
+  /// Stores the given functor and a cache of the given count of results,
+  /// which is partitioned into the given count of shards.
+  template<typename T,
+           typename std::enable_if<
+            std::is_constructible<handler_t, T&&>::value
+           >::type* = nullptr>
+  explicit concurrent_memoized(T&& target, std::size_t entries = 1024UL,
+                               std::size_t shards = 16UL)
+    : target_(std::forward<T>(target)), shift_(sizeof(std::size_t) * 8U) {
+    std::size_t const count =
+      detail::memoization::round_up_to_power_of_two(shards);
+    for (std::size_t i = 1UL; i < count; i <<= 1U) {
+      --shift_;
+    }
+    shards_.reserve(count);
+    for (std::size_t i = 0UL; i < count; ++i) {
+      shards_.emplace_back(new shard_t((entries + count - 1UL) / count));
+    }
+  }
+
+  concurrent_memoized(concurrent_memoized const&) = delete;
+  concurrent_memoized& operator=(concurrent_memoized const&) = delete;
+
+  /// Returns the cached result of the given arguments, the functor is
+  /// invoked and its result is cached when there is none.
+  R operator()(Args const&... args) const {
+    std::size_t const hash = detail::memoization::hash_of(args...);
+    shard_t& current = shard_of(hash);
+    {
+      std::lock_guard<std::mutex> const lock(current.mutex);
+      if (R const* const cached = current.cache.find(hash, args...))
+        return *cached;
+    }
+
+    R result = target_(args...);
+    // Another thread might have cached the result in between
+    std::lock_guard<std::mutex> const lock(current.mutex);
+    return current.cache.insert(hash, std::move(result), args...);
+  }
+
+  /// Returns the count of cached results
+  std::size_t size() const {
+    std::size_t size = 0UL;
+    for (auto const& current : shards_) {
+      std::lock_guard<std::mutex> const lock(current->mutex);
+      size += current->cache.size();
+    }
+    return size;
+  }
+
+  /// Removes all cached results
+  void clear() {
+    for (auto const& current : shards_) {
+      std::lock_guard<std::mutex> const lock(current->mutex);
+      current->cache.clear();
+    }
+  }
+};
+
+} /// namespace fu2
+
+#endif // FU2_INCLUDED_MEMOIZED_HPP__
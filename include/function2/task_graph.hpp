@@ -0,0 +1,478 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef FU2_INCLUDED_TASK_GRAPH_HPP__
+#define FU2_INCLUDED_TASK_GRAPH_HPP__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <type_traits>
+#include "function2/function2.hpp"
+
+namespace fu2 {
+namespace detail {
+inline namespace v4 {
+namespace tasks {
+
+// A task of a graph and the range of its successors
+// inside the successor list of the graph.
+template<typename Handler>
+struct node {
+  template<typename T>
+  explicit node(T&& task_)
+    : task(std::forward<T>(task_)), predecessors(0UL),
+      first_successor(0UL), last_successor(0UL) { }
+
+  Handler task;
+  std::size_t predecessors;
+  std::size_t first_successor;
+  std::size_t last_successor;
+};
+
+// Marks an empty slot of the ready queue
+constexpr std::size_t no_task() {
+  return ~std::size_t(0);
+}
+
+// The count of times an idle worker checks the ready queue
+// before it blocks.
+constexpr std::size_t spin_count() {
+  return 64UL;
+}
+
+// Counts the events which idle workers wait for, a worker blocks until
+// the count changed from the one which it observed. Notifying is cheap
+// while no worker is blocked.
+class event_count {
+  std::atomic<std::size_t> events_;
+  std::atomic<std::size_t> waiters_;
+#if !defined(__cpp_lib_atomic_wait) || (__cpp_lib_atomic_wait < 201907L)
+  std::mutex mutex_;
+  std::condition_variable condition_;
+#endif
+
+public:
+  event_count() : events_(0UL), waiters_(0UL) { }
+  event_count(event_count const&) = delete;
+  event_count& operator=(event_count const&) = delete;
+
+  std::size_t load() const {
+    return events_.load(std::memory_order_acquire);
+  }
+
+  // Either the notifying thread observes the waiter, or the waiter
+  // observes the changed count, since both are sequentially consistent.
+  void notify() {
+    events_.fetch_add(1UL, std::memory_order_seq_cst);
+    if (waiters_.load(std::memory_order_seq_cst) == 0UL)
+      return;
+
+#if defined(__cpp_lib_atomic_wait) && (__cpp_lib_atomic_wait >= 201907L)
+    events_.notify_all();
+#else
+    {
+      std::lock_guard<std::mutex> const lock(mutex_);
+    }
+    condition_.notify_all();
+#endif
+  }
+
+  // Blocks until the count changed from the observed one
+  void wait(std::size_t observed) {
+#if defined(__cpp_lib_atomic_wait) && (__cpp_lib_atomic_wait >= 201907L)
+    waiters_.fetch_add(1UL, std::memory_order_seq_cst);
+    events_.wait(observed, std::memory_order_seq_cst);
+#else
+    std::unique_lock<std::mutex> lock(mutex_);
+    waiters_.fetch_add(1UL, std::memory_order_seq_cst);
+    while (events_.load(std::memory_order_seq_cst) == observed) {
+      condition_.wait(lock);
+    }
+#endif
+    waiters_.fetch_sub(1UL, std::memory_order_relaxed);
+  }
+};
+
+} /// namespace tasks
+} /// inline namespace
+} /// namespace detail
+
+/// A pool of worker threads which invoke a job concurrently with
+/// the thread that submitted it, for instance to run task graphs.
+///
+/// The workers are started once and sleep while no job is running,
+/// jobs are submitted one at a time.
+class worker_pool {
+  using job_t = unique_function<void() const>;
+
+  std::vector<std::thread> threads_;
+  // Serializes the submitted jobs
+  std::mutex submit_mutex_;
+  std::mutex mutex_;
+  std::condition_variable wakeup_;
+  std::condition_variable done_;
+  job_t job_;
+  std::size_t generation_;
+  std::size_t active_;
+  bool is_stopping_;
+
+  void work() {
+    std::size_t seen = 0UL;
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+      wakeup_.wait(lock, [&] {
+        return is_stopping_ || (generation_ != seen);
+      });
+      if (is_stopping_)
+        return;
+
+      seen = generation_;
+      lock.unlock();
+      job_();
+      lock.lock();
+
+      if (--active_ == 0UL)
+        done_.notify_all();
+    }
+  }
+
+  static unsigned default_workers() {
+    unsigned const cores = std::thread::hardware_concurrency();
+    return cores ? (cores - 1U) : 0U;
+  }
+
+public:
+  /// Starts a worker for every core except the one of the submitting thread
+  worker_pool() : worker_pool(default_workers()) { }
+
+  /// Starts the given count of workers, the submitting thread
+  /// participates in every job additionally.
+  explicit worker_pool(unsigned workers)
+    : generation_(0UL), active_(0UL), is_stopping_(false) {
+    threads_.reserve(workers);
+    for (unsigned i = 0U; i < workers; ++i) {
+      threads_.emplace_back([this] { work(); });
+    }
+  }
+
+  worker_pool(worker_pool const&) = delete;
+  worker_pool& operator=(worker_pool const&) = delete;
+
+  /// Stops and joins all workers
+  ~worker_pool() {
+    {
+      std::lock_guard<std::mutex> const lock(mutex_);
+      is_stopping_ = true;
+    }
+    wakeup_.notify_all();
+
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  /// Returns the count of workers
+  std::size_t size() const {
+    return threads_.size();
+  }
+
+  /// Invokes the given job on every worker and on the calling thread
+  /// concurrently and returns when all invocations returned.
+  template<typename Job>
+  void run(Job&& job) {
+    std::lock_guard<std::mutex> const submit_lock(submit_mutex_);
+    {
+      std::lock_guard<std::mutex> const lock(mutex_);
+      job_ = std::forward<Job>(job);
+      active_ = threads_.size();
+      ++generation_;
+    }
+    wakeup_.notify_all();
+
+    job_();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [&] { return active_ == 0UL; });
+    job_ = nullptr;
+  }
+};
+
+/// A graph of tasks which are invoked after all of their predecessors
+/// completed, for instance the jobs which process a frame.
+///
+/// Tasks are stored in-place inside nodes which are allocated contiguously
+/// by the graph. Running the graph counts down the pending predecessors
+/// of every task atomically, and releases the successors of a completed
+/// task to the workers as soon as their last predecessor completed.
+/// Workers without a released task yield for a few times and block
+/// afterwards until a task is released or all tasks completed.
+///
+/// The graph is reusable: running it again doesn't allocate memory
+/// as long as no tasks or dependencies were added in between.
+/// The dependencies must be acyclic, and exceptions must not escape tasks.
+template<std::size_t Capacity = detail::default_capacity::value>
+class task_graph {
+  using handler_t = function_base<void(), false, Capacity>;
+  using node_t = detail::tasks::node<handler_t>;
+  using counter_t = std::atomic<std::size_t>;
+
+public:
+  /// A handle to a task of the graph
+  class task {
+    friend class task_graph;
+
+    std::size_t index_;
+
+    explicit task(std::size_t index) : index_(index) { }
+
+  public:
+    task() : index_(detail::tasks::no_task()) { }
+  };
+
+private:
+  std::vector<node_t> nodes_;
+  std::vector<std::pair<std::size_t, std::size_t>> edges_;
+  // The successors of all tasks grouped by their predecessor
+  std::vector<std::size_t> successors_;
+  std::vector<std::size_t> roots_;
+  bool is_compiled_;
+
+  // The state of a run, sized for the tasks when the graph is compiled
+  std::unique_ptr<counter_t[]> pending_;
+  std::unique_ptr<counter_t[]> ready_;
+  std::size_t state_capacity_;
+  // Keeps the counters of the queue apart from each other
+  char padding0_[64];
+  counter_t head_;
+  char padding1_[64];
+  counter_t tail_;
+  char padding2_[64];
+  counter_t remaining_;
+  char padding3_[64];
+  // Is notified when a task was released or all tasks completed
+  detail::tasks::event_count released_;
+
+  // Groups the successors by their predecessor and validates
+  // that the graph is acyclic.
+  void compile() {
+    std::size_t const size = nodes_.size();
+
+    std::vector<std::size_t> offsets(size + 1UL, 0UL);
+    for (auto& current : nodes_) {
+      current.predecessors = 0UL;
+    }
+    for (auto const& edge : edges_) {
+      ++offsets[edge.first + 1UL];
+      ++nodes_[edge.second].predecessors;
+    }
+    for (std::size_t i = 0UL; i < size; ++i) {
+      offsets[i + 1UL] += offsets[i];
+      nodes_[i].first_successor = offsets[i];
+      nodes_[i].last_successor = offsets[i];
+    }
+
+    successors_.resize(edges_.size());
+    for (auto const& edge : edges_) {
+      successors_[nodes_[edge.first].last_successor++] = edge.second;
+    }
+
+    roots_.clear();
+    for (std::size_t i = 0UL; i < size; ++i) {
+      if (nodes_[i].predecessors == 0UL)
+        roots_.push_back(i);
+    }
+
+    // Every task is reachable from the roots in topological order
+    // unless the graph contains a cycle.
+    std::vector<std::size_t> pending(size);
+    std::vector<std::size_t> order(roots_);
+    for (std::size_t i = 0UL; i < size; ++i) {
+      pending[i] = nodes_[i].predecessors;
+    }
+    for (std::size_t i = 0UL; i < order.size(); ++i) {
+      node_t const& current = nodes_[order[i]];
+      for (std::size_t j = current.first_successor;
+           j != current.last_successor; ++j) {
+        if (--pending[successors_[j]] == 0UL)
+          order.push_back(successors_[j]);
+      }
+    }
+    if (order.size() != size)
+      std::abort();
+
+    if (state_capacity_ < size) {
+      pending_.reset(new counter_t[size]);
+      ready_.reset(new counter_t[size]);
+      state_capacity_ = size;
+    }
+    is_compiled_ = true;
+  }
+
+  // Resets the state of the previous run and releases the roots
+  void prepare() {
+    if (!is_compiled_)
+      compile();
+
+    std::size_t const size = nodes_.size();
+    for (std::size_t i = 0UL; i < size; ++i) {
+      pending_[i].store(nodes_[i].predecessors, std::memory_order_relaxed);
+      ready_[i].store(detail::tasks::no_task(), std::memory_order_relaxed);
+    }
+    head_.store(0UL, std::memory_order_relaxed);
+    tail_.store(0UL, std::memory_order_relaxed);
+    remaining_.store(size, std::memory_order_relaxed);
+
+    for (std::size_t root : roots_) {
+      push(root);
+    }
+  }
+
+  // Appends a released task to the ready queue, every task
+  // is released exactly once per run.
+  void push(std::size_t index) {
+    std::size_t const slot = tail_.fetch_add(1UL, std::memory_order_relaxed);
+    ready_[slot].store(index, std::memory_order_release);
+    released_.notify();
+  }
+
+  bool is_idle() const {
+    return (head_.load(std::memory_order_relaxed) ==
+            tail_.load(std::memory_order_relaxed)) &&
+           (remaining_.load(std::memory_order_acquire) != 0UL);
+  }
+
+  // Claims a released task, returns no task when all tasks completed.
+  // Idle workers yield for a few times before they block.
+  std::size_t pop() {
+    std::size_t head = head_.load(std::memory_order_relaxed);
+    std::size_t spins = 0UL;
+    for (;;) {
+      if (head == tail_.load(std::memory_order_relaxed)) {
+        if (remaining_.load(std::memory_order_acquire) == 0UL)
+          return detail::tasks::no_task();
+
+        if (spins < detail::tasks::spin_count()) {
+          ++spins;
+          std::this_thread::yield();
+        }
+        else {
+          // The count is observed before the queue is checked again,
+          // so any task which is released afterwards wakes the worker up.
+          std::size_t const observed = released_.load();
+          if (is_idle())
+            released_.wait(observed);
+        }
+        head = head_.load(std::memory_order_relaxed);
+      }
+      else if (head_.compare_exchange_weak(head, head + 1UL,
+                                           std::memory_order_relaxed)) {
+        break;
+      }
+    }
+
+    // The slot was reserved already but might not be written yet
+    std::size_t index;
+    while ((index = ready_[head].load(std::memory_order_acquire)) ==
+           detail::tasks::no_task()) {
+      std::this_thread::yield();
+    }
+    return index;
+  }
+
+  // Invokes released tasks until all tasks completed. The first successor
+  // which is released by a task is invoked next on the same thread.
+  void work() {
+    std::size_t index = pop();
+    while (index != detail::tasks::no_task()) {
+      node_t& current = nodes_[index];
+      current.task();
+
+      std::size_t next = detail::tasks::no_task();
+      for (std::size_t i = current.first_successor;
+           i != current.last_successor; ++i) {
+        std::size_t const successor = successors_[i];
+        if (pending_[successor].fetch_sub(1UL,
+                                          std::memory_order_acq_rel) == 1UL) {
+          if (next == detail::tasks::no_task())
+            next = successor;
+          else
+            push(successor);
+        }
+      }
+
+      if (remaining_.fetch_sub(1UL, std::memory_order_release) == 1UL)
+        released_.notify();
+      index = (next != detail::tasks::no_task()) ? next : pop();
+    }
+  }
+
+public:
+  /// Constructs the graph empty
+  task_graph()
+    : is_compiled_(false), state_capacity_(0UL), head_(0UL), tail_(0UL),
+      remaining_(0UL) { }
+
+  task_graph(task_graph const&) = delete;
+  task_graph& operator=(task_graph const&) = delete;
+
+  /// Adds the given callable as task without any dependencies
+  template<typename T,
+           typename std::enable_if<
+            std::is_constructible<handler_t, T&&>::value
+           >::type* = nullptr>
+  task emplace(T&& callable) {
+    nodes_.emplace_back(std::forward<T>(callable));
+    is_compiled_ = false;
+    return task(nodes_.size() - 1UL);
+  }
+
+  /// Invokes the after task only after the before task completed
+  void precede(task before, task after) {
+    edges_.emplace_back(before.index_, after.index_);
+    is_compiled_ = false;
+  }
+
+  /// Returns the count of tasks
+  std::size_t size() const {
+    return nodes_.size();
+  }
+
+  /// Returns true when the graph doesn't contain any task
+  bool empty() const {
+    return nodes_.empty();
+  }
+
+  /// Removes all tasks and dependencies, the storage is kept
+  void clear() {
+    nodes_.clear();
+    edges_.clear();
+    is_compiled_ = false;
+  }
+
+  /// Invokes all tasks on the calling thread
+  void run() {
+    prepare();
+    work();
+  }
+
+  /// Invokes all tasks on the workers of the given pool and
+  /// the calling thread, returns when all tasks completed.
+  void run(worker_pool& pool) {
+    prepare();
+    pool.run([this] { work(); });
+  }
+};
+
+} /// namespace fu2
+
+#endif // FU2_INCLUDED_TASK_GRAPH_HPP__
@@ -0,0 +1,408 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef FU2_INCLUDED_TIMER_WHEEL_HPP__
+#define FU2_INCLUDED_TIMER_WHEEL_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <type_traits>
+#include "function2/function2.hpp"
+
+namespace fu2 {
+namespace detail {
+inline namespace v4 {
+namespace timers {
+
+// Marks the end of a list of timer entries
+constexpr std::uint32_t no_entry() {
+  return ~std::uint32_t(0);
+}
+
+// The count of slots per wheel as power of two
+constexpr unsigned slot_bits() {
+  return 6U;
+}
+
+constexpr std::uint32_t slot_count() {
+  return std::uint32_t(1) << slot_bits();
+}
+
+// The count of cascading wheels, timers which expire beyond the range
+// of the last wheel are cascaded again when the wheel turned around.
+constexpr unsigned wheel_count() {
+  return 6U;
+}
+
+static_assert(slot_count() == 64U,
+              "The occupied slots of a wheel are tracked by 64 bits!");
+
+// Returns the count of trailing zero bits of a non zero value
+inline unsigned count_trailing_zeros(std::uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<unsigned>(__builtin_ctzll(value));
+#else
+  unsigned count = 0U;
+  for (; !(value & 1U); value >>= 1U) {
+    ++count;
+  }
+  return count;
+#endif
+}
+
+// A timer inside the slab of a wheel, entries are linked into the
+// slot which they expire in or into the free list.
+template<typename Handler>
+struct entry {
+  entry()
+    : expires(0U), previous(no_entry()), next(no_entry()),
+      slot(no_entry()), generation(0U) { }
+
+  Handler callback;
+  std::uint64_t expires;
+  std::uint32_t previous;
+  std::uint32_t next;
+  // The slot the entry is linked into, no entry when it is unused
+  std::uint32_t slot;
+  // Distinguishes the timers of a reused entry
+  std::uint32_t generation;
+};
+
+} /// namespace timers
+} /// inline namespace
+} /// namespace detail
+
+/// A hierarchical timer wheel which invokes callbacks after a delay
+/// that is measured in ticks, for instance connection timeouts.
+///
+/// Scheduling and cancelling a timer is O(1). Timers are linked into
+/// the slots of cascading wheels with 64 slots each, the first wheel
+/// has a resolution of one tick and timers are moved to the lower wheels
+/// when the next wheel turns. Callbacks are stored in-place inside
+/// a slab of timer entries, thus arming a timer with a small callback
+/// never allocates memory once the slab reserved enough entries.
+///
+/// Advancing the wheel skips ticks without any expiring timer, timers which
+/// expire at the same tick are invoked in order of their scheduling.
+/// The wheel isn't synchronized, callbacks are invoked on the thread
+/// which advances the wheel and are allowed to schedule and cancel timers.
+template<std::size_t Capacity = detail::default_capacity::value>
+class timer_wheel {
+  using handler_t = function_base<void(), false, Capacity>;
+  using entry_t = detail::timers::entry<handler_t>;
+
+public:
+  /// A handle to a scheduled timer
+  class timer {
+    friend class timer_wheel;
+
+    std::uint32_t index_;
+    std::uint32_t generation_;
+
+    timer(std::uint32_t index, std::uint32_t generation)
+      : index_(index), generation_(generation) { }
+
+  public:
+    timer() : index_(detail::timers::no_entry()), generation_(0U) { }
+
+    /// Returns true when the handle refers to a timer
+    explicit operator bool() const {
+      return index_ != detail::timers::no_entry();
+    }
+  };
+
+private:
+  std::vector<entry_t> entries_;
+  // The first and last entry of every slot
+  std::uint32_t heads_[detail::timers::wheel_count() *
+                       detail::timers::slot_count()];
+  std::uint32_t tails_[detail::timers::wheel_count() *
+                       detail::timers::slot_count()];
+  // The slots of every wheel which contain any entry
+  std::uint64_t occupied_[detail::timers::wheel_count()];
+  std::uint32_t free_;
+  std::uint64_t now_;
+  std::size_t size_;
+
+  void link(std::uint32_t index, std::uint32_t slot) {
+    using namespace detail::timers;
+
+    entry_t& current = entries_[index];
+    current.slot = slot;
+    current.previous = tails_[slot];
+    current.next = no_entry();
+    if (current.previous != no_entry())
+      entries_[current.previous].next = index;
+    else
+      heads_[slot] = index;
+    tails_[slot] = index;
+
+    occupied_[slot / slot_count()] |=
+      std::uint64_t(1) << (slot % slot_count());
+  }
+
+  // Links the entry in front of all other entries of the slot
+  void link_front(std::uint32_t index, std::uint32_t slot) {
+    using namespace detail::timers;
+
+    entry_t& current = entries_[index];
+    current.slot = slot;
+    current.previous = no_entry();
+    current.next = heads_[slot];
+    if (current.next != no_entry())
+      entries_[current.next].previous = index;
+    else
+      tails_[slot] = index;
+    heads_[slot] = index;
+
+    occupied_[slot / slot_count()] |=
+      std::uint64_t(1) << (slot % slot_count());
+  }
+
+  void unlink(std::uint32_t index) {
+    using namespace detail::timers;
+
+    entry_t& current = entries_[index];
+    if (current.previous != no_entry())
+      entries_[current.previous].next = current.next;
+    else
+      heads_[current.slot] = current.next;
+
+    if (current.next != no_entry())
+      entries_[current.next].previous = current.previous;
+    else
+      tails_[current.slot] = current.previous;
+
+    if (heads_[current.slot] == no_entry())
+      occupied_[current.slot / slot_count()] &=
+        ~(std::uint64_t(1) << (current.slot % slot_count()));
+  }
+
+  // Returns the slot of the wheel which covers the delay of the entry
+  std::uint32_t slot_of(std::uint32_t index) const {
+    using namespace detail::timers;
+
+    std::uint64_t const expires = entries_[index].expires;
+    std::uint64_t const delay = (expires > now_) ? (expires - now_) : 0U;
+
+    for (unsigned wheel = 0U; wheel < wheel_count(); ++wheel) {
+      if ((wheel == wheel_count() - 1U) ||
+          (delay < (std::uint64_t(1) << (slot_bits() * (wheel + 1U))))) {
+        // Timers which expire beyond the last wheel are placed in the slot
+        // which is cascaded last, and cascaded again from there.
+        std::uint64_t const at = (delay < (std::uint64_t(1) <<
+                                  (slot_bits() * wheel_count())))
+          ? expires
+          : now_ + (std::uint64_t(slot_count() - 1U) <<
+                    (slot_bits() * wheel));
+        return wheel * slot_count() + static_cast<std::uint32_t>(
+          (at >> (slot_bits() * wheel)) & (slot_count() - 1U));
+      }
+    }
+    return no_entry();
+  }
+
+  // Moves the timers of the current slot of the given wheel
+  // to the lower wheels, returns the index of the slot.
+  //
+  // Timers of a higher wheel were scheduled before the timers of lower
+  // wheels which expire at the same tick, thus the cascaded timers are
+  // linked in front of the lower slots and in their order.
+  std::uint32_t cascade(unsigned wheel) {
+    using namespace detail::timers;
+
+    std::uint32_t const slot = static_cast<std::uint32_t>(
+      (now_ >> (slot_bits() * wheel)) & (slot_count() - 1U));
+    std::uint32_t index = tails_[wheel * slot_count() + slot];
+    heads_[wheel * slot_count() + slot] = no_entry();
+    tails_[wheel * slot_count() + slot] = no_entry();
+    occupied_[wheel] &= ~(std::uint64_t(1) << slot);
+
+    while (index != no_entry()) {
+      std::uint32_t const previous = entries_[index].previous;
+      link_front(index, slot_of(index));
+      index = previous;
+    }
+    return slot;
+  }
+
+  // Returns the next tick at which any slot is cascaded or expires,
+  // or the maximum tick when no timer is scheduled.
+  std::uint64_t next_event() const {
+    using namespace detail::timers;
+
+    std::uint64_t next = ~std::uint64_t(0);
+    for (unsigned wheel = 0U; wheel < wheel_count(); ++wheel) {
+      std::uint64_t const occupied = occupied_[wheel];
+      if (!occupied)
+        continue;
+
+      // Rotates the bits, so the slot after the current one comes first
+      std::uint64_t const turns = now_ >> (slot_bits() * wheel);
+      unsigned const first = static_cast<unsigned>(
+        (turns + 1U) & (slot_count() - 1U));
+      std::uint64_t const rotated = first
+        ? ((occupied >> first) | (occupied << (slot_count() - first)))
+        : occupied;
+
+      std::uint64_t const at = (turns + 1U + count_trailing_zeros(rotated))
+                               << (slot_bits() * wheel);
+      if (at < next)
+        next = at;
+    }
+    return next;
+  }
+
+  // Advances the wheel by a single tick, returns the count of
+  // invoked callbacks.
+  std::size_t step() {
+    using namespace detail::timers;
+
+    ++now_;
+
+    // Cascades the next wheel whenever a wheel turned around
+    for (unsigned wheel = 1U; wheel < wheel_count(); ++wheel) {
+      if ((now_ & ((std::uint64_t(1) << (slot_bits() * wheel)) - 1U)) ||
+          cascade(wheel)) {
+        break;
+      }
+    }
+
+    // The callbacks are moved out before invoking them,
+    // so they are able to schedule and cancel timers.
+    std::size_t expired = 0UL;
+    std::uint32_t const slot =
+      static_cast<std::uint32_t>(now_ & (slot_count() - 1U));
+    while (heads_[slot] != no_entry()) {
+      std::uint32_t const index = heads_[slot];
+      unlink(index);
+      handler_t callback = std::move(entries_[index].callback);
+      entries_[index].callback = nullptr;
+      release(index);
+
+      callback();
+      ++expired;
+    }
+    return expired;
+  }
+
+  void release(std::uint32_t index) {
+    entry_t& current = entries_[index];
+    current.slot = detail::timers::no_entry();
+    current.next = free_;
+    ++current.generation;
+    free_ = index;
+    --size_;
+  }
+
+public:
+  /// Constructs the wheel empty at the given time
+  explicit timer_wheel(std::uint64_t now = 0U)
+    : free_(detail::timers::no_entry()), now_(now), size_(0UL) {
+    for (std::size_t slot = 0UL; slot < (detail::timers::wheel_count() *
+                                         detail::timers::slot_count());
+         ++slot) {
+      heads_[slot] = detail::timers::no_entry();
+      tails_[slot] = detail::timers::no_entry();
+    }
+    for (auto& occupied : occupied_) {
+      occupied = 0U;
+    }
+  }
+
+  timer_wheel(timer_wheel const&) = delete;
+  timer_wheel& operator=(timer_wheel const&) = delete;
+
+  /// Reserves the slab for the given count of concurrent timers
+  void reserve(std::size_t timers) {
+    entries_.reserve(timers);
+  }
+
+  /// Invokes the given callback once the wheel advanced by the given delay
+  /// of ticks, a delay of zero expires on the next tick.
+  template<typename T,
+           typename std::enable_if<
+            std::is_constructible<handler_t, T&&>::value
+           >::type* = nullptr>
+  timer schedule(std::uint64_t delay, T&& callback) {
+    // Constructs the callback before taking an entry, which would leak
+    // when the construction throws.
+    handler_t handler(std::forward<T>(callback));
+
+    std::uint32_t index = free_;
+    if (index != detail::timers::no_entry()) {
+      free_ = entries_[index].next;
+    }
+    else {
+      index = static_cast<std::uint32_t>(entries_.size());
+      entries_.emplace_back();
+    }
+
+    entry_t& current = entries_[index];
+    current.callback = std::move(handler);
+    current.expires = now_ + (delay ? delay : 1U);
+    link(index, slot_of(index));
+    ++size_;
+    return timer(index, current.generation);
+  }
+
+  /// Cancels the given timer and destroys its callback
+  ///
+  /// Returns false when the timer expired or was cancelled already.
+  bool cancel(timer const& handle) {
+    if ((handle.index_ >= entries_.size()) ||
+        (entries_[handle.index_].generation != handle.generation_) ||
+        (entries_[handle.index_].slot == detail::timers::no_entry())) {
+      return false;
+    }
+
+    unlink(handle.index_);
+    entries_[handle.index_].callback = nullptr;
+    release(handle.index_);
+    return true;
+  }
+
+  /// Advances the wheel by the given count of ticks and invokes
+  /// the callbacks of all expired timers in order of their expiry,
+  /// returns the count of invoked callbacks.
+  std::size_t advance(std::uint64_t ticks = 1U) {
+    std::uint64_t const target = now_ + ticks;
+    std::size_t expired = 0UL;
+
+    while (now_ != target) {
+      std::uint64_t const next = next_event();
+      if (next > target) {
+        now_ = target;
+        break;
+      }
+
+      now_ = next - 1U;
+      expired += step();
+    }
+    return expired;
+  }
+
+  /// Returns the current time of the wheel in ticks
+  std::uint64_t now() const {
+    return now_;
+  }
+
+  /// Returns the count of scheduled timers
+  std::size_t size() const {
+    return size_;
+  }
+
+  /// Returns true when no timer is scheduled
+  bool empty() const {
+    return size_ == 0UL;
+  }
+};
+
+} /// namespace fu2
+
+#endif // FU2_INCLUDED_TIMER_WHEEL_HPP__
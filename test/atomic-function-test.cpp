@@ -0,0 +1,131 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "function2/atomic_function.hpp"
+#include "function2-test.hpp"
+
+namespace {
+  /// Invalidates its value on destruction, invoking a destroyed functor
+  /// is detected through the invocation result (or the address sanitizer).
+  struct DestructionTracker {
+    std::shared_ptr<int> value;
+
+    explicit DestructionTracker(int value_)
+      : value(std::make_shared<int>(value_)) { }
+
+    DestructionTracker(DestructionTracker&&) = default;
+    DestructionTracker& operator=(DestructionTracker&&) = default;
+
+    ~DestructionTracker() {
+      if (value)
+        *value = -1;
+    }
+
+    int operator() () const {
+      return *value;
+    }
+  };
+}
+
+TEST(atomic_function_tests, are_empty_on_default_construction)
+{
+  fu2::atomic_function<int(int)> fn;
+  EXPECT_TRUE(fn.empty());
+  EXPECT_FALSE(fn);
+}
+
+TEST(atomic_function_tests, are_invocable)
+{
+  fu2::atomic_function<int(int, int)> fn([](int left, int right) {
+    return left + right;
+  });
+  EXPECT_TRUE(fn);
+  EXPECT_EQ(fn(2, 3), 5);
+}
+
+TEST(atomic_function_tests, are_replaceable)
+{
+  fu2::atomic_function<bool()> fn(returnTrue);
+  EXPECT_TRUE(fn());
+  fn.store(returnFalse);
+  EXPECT_FALSE(fn());
+  fn.store(fu2::function<bool() const>([] { return true; }));
+  EXPECT_TRUE(fn());
+  fn.store(nullptr);
+  EXPECT_TRUE(fn.empty());
+}
+
+TEST(atomic_function_tests, are_destroying_replaced_targets)
+{
+  auto const state = std::make_shared<int>(0);
+  fu2::atomic_function<int()> fn([state] { return *state; });
+  EXPECT_EQ(state.use_count(), 2L);
+  fn.store([] { return 1; });
+  EXPECT_EQ(state.use_count(), 1L);
+
+  {
+    fu2::atomic_function<int()> other([state] { return *state; });
+    EXPECT_EQ(state.use_count(), 2L);
+  }
+  EXPECT_EQ(state.use_count(), 1L);
+}
+
+TEST(atomic_function_tests, are_keeping_invoked_targets_alive)
+{
+  auto const state = std::make_shared<int>(7);
+  fu2::atomic_function<int()> fn;
+  fn.store([&fn, state] {
+    // Replaces the target which is currently invoked
+    fn.store([] { return 0; });
+    return *state;
+  });
+  EXPECT_EQ(fn(), 7);
+  EXPECT_EQ(fn(), 0);
+  fn.store(nullptr);
+  EXPECT_EQ(state.use_count(), 1L);
+}
+
+TEST(atomic_function_tests, are_reading_concurrently_while_replaced)
+{
+  fu2::atomic_function<int()> fn(DestructionTracker(0));
+
+  std::atomic<bool> is_running(true);
+  std::atomic<bool> is_valid(true);
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; ++i) {
+    readers.emplace_back([&] {
+      while (is_running.load()) {
+        if (fn() < 0) {
+          is_valid.store(false);
+        }
+      }
+    });
+  }
+
+  for (int i = 1; i <= 2000; ++i) {
+    fn.store(DestructionTracker(i));
+  }
+  is_running.store(false);
+
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  EXPECT_TRUE(is_valid.load());
+  EXPECT_EQ(fn(), 2000);
+}
+
+#ifndef TESTS_NO_EXCEPTIONS
+TEST(atomic_function_tests, are_throwing_on_empty_invocation)
+{
+  fu2::atomic_function<void()> fn;
+  EXPECT_THROW(fn(), fu2::bad_function_call);
+  fn.store([] { });
+  EXPECT_NO_THROW(fn());
+}
+#endif // TESTS_NO_EXCEPTIONS
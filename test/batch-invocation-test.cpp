@@ -0,0 +1,134 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+#include <array>
+#include <string>
+#include <vector>
+#include "function2-test.hpp"
+
+namespace {
+  /// Functor which accumulates its arguments
+  struct Accumulator {
+    int sum;
+
+    int operator() (int i) {
+      return sum += i;
+    }
+  };
+
+  /// Functor which doesn't fit into the default capacity
+  struct LargeScale {
+    std::array<float, 16> factors;
+
+    float operator() (float value) const {
+      return value * factors[0];
+    }
+  };
+
+  /// Is a true type when the function T provides a batched invocation
+  template<typename T, typename = void>
+  struct is_batch_invocable : std::false_type { };
+
+  template<typename T>
+  struct is_batch_invocable<T, decltype((void)std::declval<T&>().invoke_batch(
+    nullptr, nullptr, nullptr))> : std::true_type { };
+}
+
+ALL_LEFT_TYPED_TEST_CASE(AllBatchInvocationTests)
+
+TYPED_TEST(AllBatchInvocationTests, AreInvokingTheTargetForEveryArgument)
+{
+  typename TestFixture::template left_t<int(int)> left = Accumulator{0};
+
+  std::vector<int> const input = {1, 2, 3, 4};
+  std::vector<int> output(input.size());
+  left.invoke_batch(input.data(), input.data() + input.size(), output.data());
+  EXPECT_EQ(output, (std::vector<int>{1, 3, 6, 10}));
+
+  // The state of the functor is kept between batches
+  EXPECT_EQ(left(5), 15);
+}
+
+TYPED_TEST(AllBatchInvocationTests, AreInvokingNothingForEmptyRanges)
+{
+  typename TestFixture::template left_t<int(int)> left = Accumulator{0};
+  left.invoke_batch(nullptr, nullptr, nullptr);
+  EXPECT_EQ(left(1), 1);
+}
+
+TYPED_TEST(AllBatchInvocationTests, AreInvokingHeapAllocatedTargets)
+{
+  LargeScale scale;
+  scale.factors[0] = 2.f;
+  typename TestFixture::template left_t<float(float) const> left = scale;
+
+  float const input[] = {1.f, 2.f, 3.f};
+  float output[3] = {};
+  auto const& constant = left;
+  constant.invoke_batch(input, input + 3, output);
+  EXPECT_EQ(output[0], 2.f);
+  EXPECT_EQ(output[1], 4.f);
+  EXPECT_EQ(output[2], 6.f);
+}
+
+TYPED_TEST(AllBatchInvocationTests, AreConvertingArgumentsAndResults)
+{
+  typename TestFixture::template left_t<std::size_t(std::string const&)>
+    left = [](std::string const& str) { return str.size(); };
+
+  std::string const input[] = {"a", "abc", ""};
+  std::size_t output[3] = {};
+  left.invoke_batch(input, input + 3, output);
+  EXPECT_EQ(output[0], 1UL);
+  EXPECT_EQ(output[1], 3UL);
+  EXPECT_EQ(output[2], 0UL);
+}
+
+#ifndef TESTS_NO_EXCEPTIONS
+TYPED_TEST(AllBatchInvocationTests, AreThrowingIfEmpty)
+{
+  typename TestFixture::template left_t<int(int)> left;
+  int const input[] = {1};
+  int output[1] = {};
+  EXPECT_THROW(left.invoke_batch(input, input + 1, output),
+               fu2::bad_function_call);
+}
+#endif // TESTS_NO_EXCEPTIONS
+
+TEST(batch_invocation_tests, are_invoking_compact_functions)
+{
+  fu2::compact_function<int(int)> fn = Accumulator{10};
+  int const input[] = {1, 2};
+  int output[2] = {};
+  fn.invoke_batch(input, input + 2, output);
+  EXPECT_EQ(output[0], 11);
+  EXPECT_EQ(output[1], 13);
+}
+
+TEST(batch_invocation_tests, are_invoking_adopted_targets)
+{
+  fu2::function<int(int)> fn = Accumulator{0};
+  fu2::function<long(int)> adopted = std::move(fn);
+
+  int const input[] = {1, 2};
+  long output[2] = {};
+  adopted.invoke_batch(input, input + 2, output);
+  EXPECT_EQ(output[0], 1L);
+  EXPECT_EQ(output[1], 3L);
+}
+
+TEST(batch_invocation_tests, are_only_provided_for_unary_signatures)
+{
+  EXPECT_TRUE((is_batch_invocable<fu2::function<float(float)>>::value));
+  EXPECT_TRUE((is_batch_invocable<fu2::function<int(int const&)>>::value));
+  EXPECT_FALSE((is_batch_invocable<fu2::function<void(int)>>::value));
+  EXPECT_FALSE((is_batch_invocable<fu2::function<int(int&)>>::value));
+  EXPECT_FALSE((is_batch_invocable<fu2::function<int(int, int)>>::value));
+  EXPECT_FALSE((is_batch_invocable<fu2::function<int&(int)>>::value));
+  EXPECT_FALSE((is_batch_invocable<fu2::unique_function<int(int) &&>>::value));
+  EXPECT_FALSE((is_batch_invocable<fu2::unique_function<
+    int(std::unique_ptr<int>)>>::value));
+}
@@ -0,0 +1,201 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "function2/callback_list.hpp"
+#include "function2-test.hpp"
+
+namespace {
+  /// Handler which records the address it is stored at
+  class AddressRecorder
+  {
+    std::vector<char const*>* addresses_;
+
+  public:
+    explicit AddressRecorder(std::vector<char const*>& addresses)
+      : addresses_(&addresses) { }
+
+    void operator() () const
+    {
+      addresses_->push_back(reinterpret_cast<char const*>(this));
+    }
+  };
+
+  /// Handler whose copy throws
+  struct ThrowingCopy
+  {
+    ThrowingCopy() = default;
+    ThrowingCopy(ThrowingCopy&&) = default;
+
+    ThrowingCopy(ThrowingCopy const&)
+    {
+      throw std::runtime_error("copy");
+    }
+
+    void operator() () const { }
+  };
+}
+
+TEST(callback_list_tests, are_invoking_nothing_when_empty)
+{
+  fu2::callback_list<void(int)> list;
+  list(1);
+  list.emit(2);
+}
+
+TEST(callback_list_tests, are_invoking_in_order_of_subscription)
+{
+  std::vector<int> calls;
+  fu2::callback_list<void(int)> list;
+  auto first = list.subscribe([&](int i) { calls.push_back(i); });
+  auto second = list.subscribe([&](int i) { calls.push_back(i * 10); });
+  EXPECT_TRUE(first);
+  EXPECT_TRUE(second);
+
+  list(2);
+  EXPECT_EQ(calls, (std::vector<int>{2, 20}));
+}
+
+TEST(callback_list_tests, are_unsubscribable)
+{
+  int calls = 0;
+  fu2::callback_list<void()> list;
+  auto first = list.subscribe([&] { calls += 1; });
+  auto second = list.subscribe([&] { calls += 10; });
+  auto third = list.subscribe([&] { calls += 100; });
+
+  EXPECT_TRUE(list.unsubscribe(second));
+  EXPECT_FALSE(list.unsubscribe(second));
+  list();
+  EXPECT_EQ(calls, 101);
+
+  EXPECT_TRUE(list.unsubscribe(first));
+  EXPECT_TRUE(list.unsubscribe(third));
+  list();
+  EXPECT_EQ(calls, 101);
+
+  EXPECT_FALSE(list.unsubscribe(decltype(first){}));
+}
+
+TEST(callback_list_tests, are_rejecting_outdated_subscriptions)
+{
+  int calls = 0;
+  fu2::callback_list<void()> list;
+  auto first = list.subscribe([&] { calls += 1; });
+  EXPECT_TRUE(list.unsubscribe(first));
+
+  // Reuses the storage of the first handler
+  auto second = list.subscribe([&] { calls += 10; });
+  EXPECT_FALSE(list.unsubscribe(first));
+  list();
+  EXPECT_EQ(calls, 10);
+  EXPECT_TRUE(list.unsubscribe(second));
+}
+
+TEST(callback_list_tests, are_destroying_unsubscribed_handlers)
+{
+  auto const state = std::make_shared<int>(0);
+  {
+    fu2::callback_list<void()> list;
+    auto handle = list.subscribe([state] { });
+    list.subscribe([state] { });
+    EXPECT_EQ(state.use_count(), 3L);
+    list.unsubscribe(handle);
+    EXPECT_EQ(state.use_count(), 2L);
+  }
+  EXPECT_EQ(state.use_count(), 1L);
+}
+
+#ifndef TESTS_NO_EXCEPTIONS
+TEST(callback_list_tests, are_reusing_nodes_when_subscribing_throws)
+{
+  std::vector<char const*> expected;
+  {
+    fu2::callback_list<void()> list;
+    list.subscribe(AddressRecorder(expected));
+    list.subscribe(AddressRecorder(expected));
+    list();
+  }
+
+  // The node of the failed subscription is reused by the next one
+  std::vector<char const*> addresses;
+  fu2::callback_list<void()> list;
+  list.subscribe(AddressRecorder(addresses));
+  ThrowingCopy const throwing;
+  EXPECT_THROW(list.subscribe(throwing), std::runtime_error);
+  list.subscribe(AddressRecorder(addresses));
+  list();
+
+  ASSERT_EQ(addresses.size(), 2UL);
+  ASSERT_EQ(expected.size(), 2UL);
+  EXPECT_EQ(addresses[1] - addresses[0], expected[1] - expected[0]);
+}
+#endif // TESTS_NO_EXCEPTIONS
+
+TEST(callback_list_tests, are_subscribable_while_emitting)
+{
+  int calls = 0;
+  fu2::callback_list<void()> list;
+  fu2::callback_list<void()>::subscription self;
+  self = list.subscribe([&] {
+    ++calls;
+    // Changes aren't visible to the current emit
+    list.subscribe([&] { calls += 10; });
+    list.unsubscribe(self);
+  });
+
+  list();
+  EXPECT_EQ(calls, 1);
+  list();
+  EXPECT_EQ(calls, 11);
+}
+
+TEST(callback_list_tests, are_skipping_handlers_unsubscribed_while_emitting)
+{
+  int calls = 0;
+  fu2::callback_list<void()> list;
+  fu2::callback_list<void()>::subscription second;
+  list.subscribe([&] { list.unsubscribe(second); });
+  second = list.subscribe([&] { ++calls; });
+
+  list();
+  EXPECT_EQ(calls, 0);
+}
+
+TEST(callback_list_tests, are_emitting_concurrently_while_subscribing)
+{
+  fu2::callback_list<void(std::atomic<int>&)> list;
+  list.subscribe([](std::atomic<int>& calls) { calls.fetch_add(1); });
+
+  std::atomic<bool> is_running(true);
+  std::vector<std::thread> emitters;
+  for (int i = 0; i < 4; ++i) {
+    emitters.emplace_back([&] {
+      std::atomic<int> calls(0);
+      do {
+        list(calls);
+      } while (is_running.load());
+      EXPECT_GT(calls.load(), 0);
+    });
+  }
+
+  for (int i = 0; i < 1000; ++i) {
+    auto const state = std::make_shared<int>(i);
+    auto handle = list.subscribe([state](std::atomic<int>& calls) {
+      calls.fetch_add(*state >= 0 ? 0 : 1);
+    });
+    list.unsubscribe(handle);
+  }
+  is_running.store(false);
+
+  for (auto& emitter : emitters) {
+    emitter.join();
+  }
+}
@@ -0,0 +1,117 @@
+# Compiles a codegen probe into assembly and checks the expectations
+# which are written as comments into the probe:
+#
+#   // FORBID: <regex>            The regex doesn't match anywhere in the
+#                                 assembly
+#   // EXPECT: <symbol> <regex>   The regex matches inside the body of the
+#                                 given (unmangled) function
+#   // BUDGET: <symbol> <count>   The body of the given function consists
+#                                 of at most count instructions
+#
+# Usage: cmake -DCOMPILER=<c++> -DINCLUDE_DIR=<dir> -DSOURCE=<probe>
+#              -DOUTPUT=<asm> [-DSTANDARD=<11|14|17|20>]
+#              -P check-codegen.cmake
+
+if (NOT STANDARD)
+  set(STANDARD 11)
+endif()
+
+execute_process(
+  COMMAND "${COMPILER}" -std=c++${STANDARD} -O2 -S -fno-asynchronous-unwind-tables
+          "-I${INCLUDE_DIR}" "${SOURCE}" -o "${OUTPUT}"
+  RESULT_VARIABLE result
+  ERROR_VARIABLE error)
+
+if (NOT result EQUAL 0)
+  message(FATAL_ERROR "Failed to compile ${SOURCE}:\n${error}")
+endif()
+
+file(READ "${OUTPUT}" assembly)
+file(STRINGS "${SOURCE}" forbidden REGEX "^// FORBID: ")
+file(STRINGS "${SOURCE}" expected REGEX "^// EXPECT: ")
+file(STRINGS "${SOURCE}" budgets REGEX "^// BUDGET: ")
+
+set(failed OFF)
+foreach(line IN LISTS forbidden)
+  string(REGEX REPLACE "^// FORBID: " "" pattern "${line}")
+  if (assembly MATCHES "${pattern}")
+    message(SEND_ERROR "Forbidden pattern '${pattern}' found in ${OUTPUT}")
+    set(failed ON)
+  else()
+    message(STATUS "Pattern '${pattern}' not present")
+  endif()
+endforeach()
+
+# Splits the assembly into the bodies of the probed functions, a body
+# ends at the first directive which closes the function.
+set(symbols)
+foreach(line IN LISTS expected budgets)
+  string(REGEX REPLACE "^// [A-Z]+: ([A-Za-z0-9_]+) .*$" "\\1" symbol "${line}")
+  list(APPEND symbols ${symbol})
+endforeach()
+if (symbols)
+  list(REMOVE_DUPLICATES symbols)
+endif()
+
+file(STRINGS "${OUTPUT}" asm_lines)
+foreach(symbol IN LISTS symbols)
+  set(body_${symbol} "")
+  set(instructions_${symbol} 0)
+  set(is_found_${symbol} OFF)
+endforeach()
+
+set(current "")
+foreach(line IN LISTS asm_lines)
+  if (line MATCHES "^([A-Za-z0-9_]+):")
+    list(FIND symbols "${CMAKE_MATCH_1}" index)
+    if (NOT index EQUAL -1)
+      set(current "${CMAKE_MATCH_1}")
+      set(is_found_${current} ON)
+    endif()
+  elseif (current)
+    if (line MATCHES "^[ \t]+\\.(size|cfi_endproc)")
+      set(current "")
+    elseif (line MATCHES "^[ \t]+[a-z]")
+      set(body_${current} "${body_${current}}${line}\n")
+      math(EXPR instructions_${current} "${instructions_${current}} + 1")
+    endif()
+  endif()
+endforeach()
+
+foreach(symbol IN LISTS symbols)
+  if (NOT is_found_${symbol})
+    message(SEND_ERROR "Function '${symbol}' not found in ${OUTPUT}")
+    set(failed ON)
+  endif()
+endforeach()
+
+foreach(line IN LISTS expected)
+  string(REGEX REPLACE "^// EXPECT: ([A-Za-z0-9_]+) (.*)$" "\\1" symbol "${line}")
+  string(REGEX REPLACE "^// EXPECT: ([A-Za-z0-9_]+) (.*)$" "\\2" pattern "${line}")
+  if (body_${symbol} MATCHES "${pattern}")
+    message(STATUS "Pattern '${pattern}' present in ${symbol}")
+  else()
+    message(SEND_ERROR "Expected pattern '${pattern}' not found in ${symbol}:\n"
+                       "${body_${symbol}}")
+    set(failed ON)
+  endif()
+endforeach()
+
+foreach(line IN LISTS budgets)
+  string(REGEX REPLACE "^// BUDGET: ([A-Za-z0-9_]+) ([0-9]+)$" "\\1" symbol "${line}")
+  string(REGEX REPLACE "^// BUDGET: ([A-Za-z0-9_]+) ([0-9]+)$" "\\2" budget "${line}")
+  set(instructions ${instructions_${symbol}})
+  if (instructions GREATER budget)
+    message(SEND_ERROR "Function ${symbol} consists of ${instructions} "
+                       "instructions, the budget is ${budget}:\n"
+                       "${body_${symbol}}")
+    set(failed ON)
+  else()
+    message(STATUS "Function ${symbol} consists of ${instructions} "
+                   "instructions (budget ${budget})")
+  endif()
+endforeach()
+
+if (failed)
+  message(FATAL_ERROR "Codegen check of ${SOURCE} failed!")
+endif()
@@ -0,0 +1,37 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+// Fused compositions are stored in-place of a function with a capacity
+// sized for all stages, constructing and invoking them doesn't allocate
+// any memory. Moves aren't probed since they can't know the stored type.
+// FORBID: (call|jmp)q?[ 	]+_?malloc
+
+#include <array>
+#include <utility>
+#include "function2/function2.hpp"
+
+namespace {
+  struct stage {
+    std::array<int, 8> values;
+
+    int operator()(int i) const {
+      return values[static_cast<std::size_t>(i) % 8] + i;
+    }
+  };
+
+  using pipeline_t = decltype(
+    fu2::compose(stage{}, stage{}).then(stage{}).then(stage{}));
+}
+
+using fused_t = fu2::fused_function<int(int), pipeline_t>;
+
+fused_t make_pipeline(stage const& first, stage const& second) {
+  return fu2::compose(first, second).then(first).then(second);
+}
+
+int invoke_pipeline(fused_t& pipeline, int value) {
+  return pipeline(value);
+}
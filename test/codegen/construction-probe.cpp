@@ -0,0 +1,74 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+// Constructing and assigning functions must not require any thread safe
+// static initialization, all vtables are constant initialized.
+// FORBID: __cxa_guard_acquire
+// FORBID: __cxa_guard_release
+
+#include <array>
+#include <utility>
+#include "function2/function2.hpp"
+
+namespace {
+  struct small_functor {
+    int value;
+
+    int operator()(int i) const {
+      return value + i;
+    }
+  };
+
+  struct large_functor {
+    std::array<int, 64> values;
+
+    int operator()(int i) const {
+      return values[0] + i;
+    }
+  };
+
+  int add_one(int i) {
+    return i + 1;
+  }
+}
+
+fu2::function<int(int)> construct_empty() {
+  return {};
+}
+
+fu2::function<int(int)> construct_inplace(int value) {
+  return small_functor{value};
+}
+
+fu2::function<int(int)> construct_allocated(int value) {
+  large_functor functor;
+  functor.values[0] = value;
+  return functor;
+}
+
+fu2::function<int(int)> construct_function_pointer() {
+  return add_one;
+}
+
+fu2::unique_function<int(int)> construct_unique(int value) {
+  return small_functor{value};
+}
+
+fu2::unique_function<int(int)> move_to_unique(fu2::function<int(int)>&& fn) {
+  return std::move(fn);
+}
+
+fu2::function<long(int)> convert(fu2::function<int(int)> const& fn) {
+  return fn;
+}
+
+void assign(fu2::function<int(int)>& fn, int value) {
+  fn = small_functor{value};
+}
+
+void reset(fu2::function<int(int)>& fn) {
+  fn = nullptr;
+}
@@ -0,0 +1,55 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+// Invoking a function is a single load of the vtable followed by
+// an indirect tail call into the invoker of the stored functor.
+// Moving a function whose functor is stored in-place doesn't allocate,
+// since it fits into the capacity of functions with the same config.
+// FORBID: (call|jmp)q?[ 	]+_?malloc
+// FORBID: __cxa_guard_acquire
+// FORBID: __cxa_guard_release
+// EXPECT: invoke_scalar jmpq?[ 	]+\*
+// BUDGET: invoke_scalar 2
+// EXPECT: invoke_reference jmpq?[ 	]+\*
+// BUDGET: invoke_reference 2
+// BUDGET: move_construct 32
+// BUDGET: move_assign 56
+// BUDGET: move_inplace 24
+
+#include <new>
+#include <utility>
+#include "function2/function2.hpp"
+
+namespace {
+  struct event {
+    int id;
+  };
+}
+
+extern "C" int invoke_scalar(fu2::function<int(int)>& fn, int value) {
+  return fn(value);
+}
+
+extern "C" void invoke_reference(fu2::unique_function<void(event&)>& fn,
+                                 event& e) {
+  fn(e);
+}
+
+extern "C" void move_construct(fu2::function<int(int)>* to,
+                               fu2::function<int(int)>& from) {
+  new (to) fu2::function<int(int)>(std::move(from));
+}
+
+extern "C" void move_assign(fu2::function<int(int)>& to,
+                            fu2::function<int(int)>& from) {
+  to = std::move(from);
+}
+
+extern "C" int move_inplace(int value) {
+  fu2::function<int(int)> fn = [value](int i) { return value + i; };
+  fu2::function<int(int)> moved = std::move(fn);
+  return moved(1);
+}
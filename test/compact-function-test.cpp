@@ -0,0 +1,160 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+#include <array>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include "function2-test.hpp"
+
+namespace {
+  /// Functor which is aligned stricter than a pointer
+  struct alignas(16) AlignedFunctor {
+    long long value;
+
+    long long operator() () const {
+      return value;
+    }
+  };
+
+  /// Functor which counts its live objects and whose copy throws
+  /// while the flag is set
+  class LiveCounter {
+    bool const* throws_;
+    int* alive_;
+    int value_;
+
+  public:
+    LiveCounter(bool const& throws, int& alive, int value)
+      : throws_(&throws), alive_(&alive), value_(value) {
+      ++*alive_;
+    }
+
+    LiveCounter(LiveCounter const& right)
+      : throws_(right.throws_), alive_(right.alive_), value_(right.value_) {
+      if (*throws_)
+        throw std::runtime_error("copy");
+      ++*alive_;
+    }
+
+    LiveCounter(LiveCounter&& right) noexcept
+      : throws_(right.throws_), alive_(right.alive_), value_(right.value_) {
+      ++*alive_;
+    }
+
+    ~LiveCounter() {
+      --*alive_;
+    }
+
+    int operator() () const {
+      return value_;
+    }
+  };
+
+  int doubled(int value) {
+    return value * 2;
+  }
+}
+
+static_assert(sizeof(fu2::compact_function<void()>) == sizeof(void*),
+              "Compact functions are required to be pointer sized!");
+static_assert(sizeof(fu2::compact_unique_function<void()>) == sizeof(void*),
+              "Compact functions are required to be pointer sized!");
+
+TEST(compact_function_tests, are_null_when_empty)
+{
+  fu2::compact_function<int(int)> fn;
+  EXPECT_FALSE(fn);
+  EXPECT_TRUE(fn == nullptr);
+
+  void* pointer;
+  std::memcpy(&pointer, &fn, sizeof(pointer));
+  EXPECT_EQ(pointer, nullptr);
+
+  fu2::compact_function<int(int)> null_pointer =
+    static_cast<int(*)(int)>(nullptr);
+  EXPECT_FALSE(null_pointer);
+}
+
+TEST(compact_function_tests, are_invocable)
+{
+  fu2::compact_function<int(int)> fn = doubled;
+  EXPECT_EQ(fn(2), 4);
+
+  std::array<int, 16> values{{3}};
+  fn = [values](int i) { return values[0] + i; };
+  EXPECT_EQ(fn(2), 5);
+
+  fu2::compact_function<long long()> aligned = AlignedFunctor{7};
+  EXPECT_EQ(aligned(), 7LL);
+}
+
+TEST(compact_function_tests, are_copyable_and_movable)
+{
+  auto const state = std::make_shared<int>(3);
+  fu2::compact_function<int()> fn = [state] { return *state; };
+  EXPECT_EQ(state.use_count(), 2L);
+
+  auto copy = fn;
+  EXPECT_EQ(state.use_count(), 3L);
+  EXPECT_EQ(copy(), 3);
+
+  fu2::compact_unique_function<int()> moved = std::move(fn);
+  EXPECT_FALSE(fn);
+  EXPECT_EQ(moved(), 3);
+  EXPECT_EQ(state.use_count(), 3L);
+
+  moved = nullptr;
+  copy = nullptr;
+  EXPECT_EQ(state.use_count(), 1L);
+}
+
+TEST(compact_function_tests, are_qualified)
+{
+  auto state = make_unique<int>(5);
+  fu2::compact_unique_function<int() &&> fn =
+    [state = std::move(state)]() mutable { return *state; };
+  EXPECT_EQ(std::move(fn)(), 5);
+
+  fu2::compact_function<int() const> const constant = [] { return 1; };
+  EXPECT_EQ(constant(), 1);
+}
+
+TEST(compact_function_tests, are_throwing_when_empty)
+{
+  fu2::compact_function<void()> fn;
+#ifndef TESTS_NO_EXCEPTIONS
+  EXPECT_THROW(fn(), fu2::bad_function_call);
+#endif
+  fn = [] { };
+  fn();
+}
+
+#ifndef TESTS_NO_EXCEPTIONS
+TEST(compact_function_tests, keep_the_target_when_the_copy_throws)
+{
+  bool throws = false;
+  int alive = 0;
+  {
+    fu2::compact_function<int()> left = LiveCounter(throws, alive, 1);
+    fu2::compact_function<int()> right = LiveCounter(throws, alive, 2);
+    EXPECT_EQ(alive, 2);
+
+    throws = true;
+    EXPECT_THROW(left = right, std::runtime_error);
+    EXPECT_EQ(left(), 1);
+    EXPECT_EQ(alive, 2);
+    EXPECT_THROW(fu2::compact_function<int()>{right}, std::runtime_error);
+    EXPECT_EQ(alive, 2);
+
+    throws = false;
+    left = right;
+    EXPECT_EQ(left(), 2);
+    EXPECT_EQ(alive, 2);
+  }
+  EXPECT_EQ(alive, 0);
+}
+#endif // TESTS_NO_EXCEPTIONS
@@ -0,0 +1,76 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+#include <array>
+#include <string>
+#include "function2-test.hpp"
+
+namespace {
+  /// Functor with a large capture which doesn't fit into the default capacity
+  struct LargeStage {
+    std::array<int, 16> values;
+
+    int operator() (int i) const {
+      return values[0] + i;
+    }
+  };
+}
+
+TEST(composition_tests, are_composable)
+{
+  auto composed = fu2::compose([](int i) { return i + 1; },
+                               [](int i) { return i * 2; },
+                               [](int i) { return std::to_string(i); });
+  EXPECT_EQ(composed(1), "4");
+
+  fu2::unique_function<std::string(int)> fn = std::move(composed);
+  EXPECT_EQ(fn(2), "6");
+}
+
+TEST(composition_tests, are_chainable_from_functions)
+{
+  fu2::unique_function<int(int)> first = [](int i) { return i + 1; };
+  auto chained = std::move(first)
+    .then([](int i) { return i * 3; })
+    .then([](int i) { return i - 1; });
+  EXPECT_FALSE(first);
+
+  fu2::unique_function<long(int)> fn = std::move(chained);
+  EXPECT_EQ(fn(1), 5L);
+}
+
+TEST(composition_tests, are_passing_no_arguments_after_void_stages)
+{
+  int calls = 0;
+  fu2::function<bool()> fn = fu2::compose([&] { ++calls; }, [&] {
+    return calls == 1;
+  });
+  EXPECT_TRUE(fn());
+  auto copy = fn;
+  EXPECT_FALSE(copy());
+}
+
+TEST(composition_tests, are_invocable_as_rvalue)
+{
+  auto state = make_unique<int>(7);
+  fu2::unique_function<int()&&> fn = fu2::compose(
+    [state = std::move(state)]() mutable { return std::move(state); },
+    [](std::unique_ptr<int> value) { return *value; });
+  EXPECT_EQ(std::move(fn)(), 7);
+}
+
+TEST(composition_tests, are_fused_inplace)
+{
+  auto composed = fu2::compose(LargeStage{{{1}}}, LargeStage{{{2}}})
+    .then(LargeStage{{{3}}});
+  using fused_t = fu2::fused_function<int(int), decltype(composed)>;
+  EXPECT_GE(sizeof(fused_t), sizeof(composed));
+
+  fused_t fn = std::move(composed);
+  EXPECT_EQ(fn(0), 6);
+  fused_t moved = std::move(fn);
+  EXPECT_EQ(moved(1), 7);
+}
@@ -0,0 +1,84 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+#include "function2-test.hpp"
+
+// Aggregates of functions are only constant initializable
+// since C++20, which requires constexpr destructors.
+#if defined(__cpp_constinit)
+  #define FU2_TEST_CONSTINIT constinit
+  #define FU2_TEST_CONSTANT_AGGREGATES
+#else
+  #define FU2_TEST_CONSTINIT
+#endif
+
+namespace {
+  bool callDuringDynamicInitialization();
+
+  // Not inline, GCC doesn't fold the null check of the address
+  // of an inline function in constant expressions when using UBSan.
+  bool constantTrue() { return true; }
+  bool constantFalse() { return false; }
+
+  // Is dynamically initialized before the functions below, which means
+  // the functions are only usable here when they are constant initialized.
+  // The functions are direct initialized, because copy initialization
+  // requires a (non constexpr) move before C++17.
+  bool const dynamicInitializationResult =
+    callDuringDynamicInitialization();
+
+  FU2_TEST_CONSTINIT fu2::function<bool()> entry(constantTrue);
+
+  FU2_TEST_CONSTINIT fu2::unique_function<bool() const> const
+    unique_entry(constantFalse);
+
+  FU2_TEST_CONSTINIT fu2::function_base<bool(), true, 0, false>
+    no_sfo_entry(constantTrue);
+
+  FU2_TEST_CONSTINIT fu2::function<bool()> const empty_entry;
+
+  FU2_TEST_CONSTINIT fu2::function<bool()> const nullptr_entry(nullptr);
+
+  FU2_TEST_CONSTINIT fu2::function<bool()> const null_pointer_entry(
+    static_cast<bool(*)()>(nullptr));
+
+#ifdef FU2_TEST_CONSTANT_AGGREGATES
+  FU2_TEST_CONSTINIT fu2::function<bool()> table[] = {
+    constantTrue,
+    constantFalse,
+    nullptr
+  };
+#endif // FU2_TEST_CONSTANT_AGGREGATES
+
+  bool callDuringDynamicInitialization()
+  {
+    bool result = entry() && !unique_entry() && no_sfo_entry() &&
+      !empty_entry && !nullptr_entry && !null_pointer_entry;
+#ifdef FU2_TEST_CONSTANT_AGGREGATES
+    result = result && table[0]() && !table[1]() && !table[2];
+#endif // FU2_TEST_CONSTANT_AGGREGATES
+    return result;
+  }
+}
+
+TEST(constant_initialization_tests, are_initialized_before_dynamic_initialization)
+{
+  EXPECT_TRUE(dynamicInitializationResult);
+}
+
+TEST(constant_initialization_tests, are_reassignable)
+{
+  fu2::function<bool()> copy = entry;
+  EXPECT_TRUE(copy());
+  entry = constantFalse;
+  EXPECT_FALSE(entry());
+  entry = [] { return true; };
+  EXPECT_TRUE(entry());
+
+  fu2::function_base<bool(), false, 0, false> moved = std::move(no_sfo_entry);
+  EXPECT_FALSE(no_sfo_entry);
+  EXPECT_TRUE(moved());
+}
@@ -0,0 +1,169 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+#include "function2/coroutine.hpp"
+#include "function2-test.hpp"
+
+#ifdef FU2_HAS_COROUTINES
+
+#include <coroutine>
+#include <exception>
+#include <thread>
+
+namespace {
+  /// Coroutine which starts eagerly and stores its result
+  struct Task {
+    struct promise_type {
+      int result = 0;
+      bool is_done = false;
+
+      Task get_return_object() {
+        return Task{std::coroutine_handle<promise_type>::from_promise(*this)};
+      }
+      std::suspend_never initial_suspend() noexcept { return {}; }
+      std::suspend_always final_suspend() noexcept { return {}; }
+      void return_value(int value) {
+        result = value;
+        is_done = true;
+      }
+      void unhandled_exception() { std::terminate(); }
+    };
+
+    std::coroutine_handle<promise_type> handle;
+
+    explicit Task(std::coroutine_handle<promise_type> handle_)
+      : handle(handle_) { }
+    Task(Task const&) = delete;
+    Task& operator=(Task const&) = delete;
+    ~Task() {
+      handle.destroy();
+    }
+
+    bool is_done() const {
+      return handle.promise().is_done;
+    }
+    int result() const {
+      return handle.promise().result;
+    }
+  };
+
+  /// Coroutine which suspends on start until it is resumed
+  struct Suspended {
+    std::suspend_always operator co_await() const { return {}; }
+  };
+
+  Task countTo(int& counter, int limit) {
+    while (counter < limit) {
+      co_await Suspended{};
+      ++counter;
+    }
+    co_return counter;
+  }
+
+  /// An asynchronous operation which completes when it is triggered
+  struct Operation {
+    fu2::unique_function<void(int)> completion;
+
+    void start(fu2::unique_function<void(int)> handler) {
+      completion = std::move(handler);
+    }
+
+    void trigger(int value) {
+      auto handler = std::move(completion);
+      handler(value);
+    }
+  };
+
+  Task awaitOperation(Operation& operation) {
+    int const result = co_await fu2::await_completion<int>(
+      [&](fu2::unique_function<void(int)> done) {
+        operation.start(std::move(done));
+      });
+    co_return result + 1;
+  }
+
+  Task awaitSynchronously() {
+    int const result = co_await fu2::await_completion<int>(
+      [](fu2::unique_function<void(int)> done) {
+        done(7);
+      });
+    co_return result;
+  }
+
+  Task awaitVoid(fu2::unique_function<void()>& pending) {
+    co_await fu2::await_completion<void>(
+      [&](fu2::unique_function<void()> done) {
+        pending = std::move(done);
+      });
+    co_return 1;
+  }
+
+  Task awaitThread(std::thread& worker) {
+    int const result = co_await fu2::await_completion<int>(
+      [&](fu2::unique_function<void(int)> done) {
+        worker = std::thread([done = std::move(done)]() mutable {
+          done(3);
+        });
+      });
+    co_return result;
+  }
+}
+
+TEST(coroutine_tests, are_resumable_through_functions)
+{
+  int counter = 0;
+  Task task = countTo(counter, 2);
+  EXPECT_EQ(counter, 0);
+
+  fu2::unique_function<void()> resume = std::coroutine_handle<>(task.handle);
+  resume();
+  EXPECT_EQ(counter, 1);
+
+  fu2::function_base<void(), true, 0> no_sfo_resume = task.handle;
+  auto copy = no_sfo_resume;
+  copy();
+  EXPECT_TRUE(task.is_done());
+  EXPECT_EQ(task.result(), 2);
+}
+
+TEST(coroutine_tests, are_awaiting_asynchronous_completions)
+{
+  Operation operation;
+  Task task = awaitOperation(operation);
+  EXPECT_FALSE(task.is_done());
+  EXPECT_TRUE(operation.completion);
+
+  operation.trigger(41);
+  EXPECT_TRUE(task.is_done());
+  EXPECT_EQ(task.result(), 42);
+}
+
+TEST(coroutine_tests, are_awaiting_synchronous_completions)
+{
+  Task task = awaitSynchronously();
+  EXPECT_TRUE(task.is_done());
+  EXPECT_EQ(task.result(), 7);
+}
+
+TEST(coroutine_tests, are_awaiting_void_completions)
+{
+  fu2::unique_function<void()> pending;
+  Task task = awaitVoid(pending);
+  EXPECT_FALSE(task.is_done());
+  pending();
+  EXPECT_TRUE(task.is_done());
+}
+
+TEST(coroutine_tests, are_awaiting_completions_from_other_threads)
+{
+  std::thread worker;
+  Task task = awaitThread(worker);
+  worker.join();
+  EXPECT_TRUE(task.is_done());
+  EXPECT_EQ(task.result(), 3);
+}
+
+#endif // FU2_HAS_COROUTINES
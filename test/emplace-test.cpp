@@ -0,0 +1,109 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+#include <array>
+#include <mutex>
+#include <stdexcept>
+#include "function2-test.hpp"
+
+namespace {
+  /// Functor which is neither copyable nor movable
+  struct Guarded {
+    std::mutex mutex;
+    int value;
+
+    explicit Guarded(int value_) : value(value_) { }
+
+    int operator() (int i) {
+      std::lock_guard<std::mutex> const lock(mutex);
+      return value += i;
+    }
+  };
+
+  /// Functor which counts its copies and moves
+  struct Counted {
+    static int copies;
+    static int moves;
+
+    std::array<int, 32> values;
+
+    Counted(int first, int second) : values{{first, second}} { }
+    Counted(Counted const& right) : values(right.values) {
+      ++copies;
+    }
+    Counted(Counted&& right) : values(right.values) {
+      ++moves;
+    }
+
+    int operator() () const {
+      return values[0] + values[1];
+    }
+  };
+
+  int Counted::copies = 0;
+  int Counted::moves = 0;
+
+  /// Functor which throws on construction
+  struct Throwing {
+    explicit Throwing(bool should_throw) {
+      if (should_throw)
+        throw std::runtime_error("construction failed");
+    }
+
+    int operator() () const {
+      return 1;
+    }
+  };
+}
+
+TEST(emplace_tests, are_constructing_non_movable_functors)
+{
+  fu2::unique_function<int(int)> fn(fu2::in_place_type_t<Guarded>{}, 1);
+  EXPECT_EQ(fn(2), 3);
+
+  fu2::unique_function<int(int)> moved = std::move(fn);
+  EXPECT_FALSE(fn);
+  EXPECT_EQ(moved(3), 6);
+
+  Guarded& guarded = moved.emplace<Guarded>(10);
+  EXPECT_EQ(guarded.value, 10);
+  EXPECT_EQ(moved(1), 11);
+}
+
+TEST(emplace_tests, are_constructing_without_temporaries)
+{
+  Counted::copies = 0;
+  Counted::moves = 0;
+
+  fu2::function<int()> fn(fu2::in_place_type_t<Counted>{}, 1, 2);
+  EXPECT_EQ(fn(), 3);
+
+  fu2::unique_function<int()> unique;
+  unique.emplace<Counted>(3, 4);
+  EXPECT_EQ(unique(), 7);
+
+  fu2::compact_function<int()> compact(fu2::in_place_type_t<Counted>{}, 5, 6);
+  EXPECT_EQ(compact(), 11);
+
+  EXPECT_EQ(Counted::copies, 0);
+  EXPECT_EQ(Counted::moves, 0);
+}
+
+#ifndef TESTS_NO_EXCEPTIONS
+TEST(emplace_tests, are_empty_when_the_construction_throws)
+{
+  fu2::unique_function<int()> fn = [] { return 0; };
+  EXPECT_THROW(fn.emplace<Throwing>(true), std::runtime_error);
+  EXPECT_FALSE(fn);
+
+  fn.emplace<Throwing>(false);
+  EXPECT_EQ(fn(), 1);
+
+  fu2::compact_unique_function<int()> compact = [] { return 0; };
+  EXPECT_THROW(compact.emplace<Throwing>(true), std::runtime_error);
+  EXPECT_FALSE(compact);
+}
+#endif // TESTS_NO_EXCEPTIONS
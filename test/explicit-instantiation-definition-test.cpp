@@ -0,0 +1,14 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+#include "function2/function2.hpp"
+
+// Usually placed inside exactly one source file of the program.
+FU2_INSTANTIATE_FUNCTION(bool())
+FU2_INSTANTIATE_FUNCTION(int(int, int) const)
+FU2_INSTANTIATE_UNIQUE_FUNCTION(bool())
+FU2_INSTANTIATE_UNIQUE_FUNCTION(int(int, int)&&)
+FU2_INSTANTIATE_FUNCTION_BASE(true, 64, false, bool(int))
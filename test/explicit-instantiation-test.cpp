@@ -0,0 +1,39 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+#include "function2-test.hpp"
+
+// Usually placed inside a header which is shared between all
+// translation units that use the signatures below.
+FU2_EXTERN_TEMPLATE_FUNCTION(bool())
+FU2_EXTERN_TEMPLATE_FUNCTION(int(int, int) const)
+FU2_EXTERN_TEMPLATE_UNIQUE_FUNCTION(bool())
+FU2_EXTERN_TEMPLATE_UNIQUE_FUNCTION(int(int, int)&&)
+FU2_EXTERN_TEMPLATE_FUNCTION_BASE(true, 64, false, bool(int))
+
+TEST(explicit_instantiation_tests, extern_functions_are_usable)
+{
+  fu2::function<bool()> first = returnTrue;
+  fu2::unique_function<bool()> second = std::move(first);
+  EXPECT_FALSE(first);
+  EXPECT_TRUE(second());
+
+  fu2::function<int(int, int) const> const add = [](int left, int right) {
+    return left + right;
+  };
+  fu2::unique_function<int(int, int)&&> sub = [](int left, int right) {
+    return left - right;
+  };
+  EXPECT_EQ(add(2, 3), 5);
+  EXPECT_EQ(std::move(sub)(5, 3), 2);
+
+  fu2::function_base<bool(int), true, 64, false> pred = [](int i) {
+    return i > 0;
+  };
+  EXPECT_TRUE(pred(1));
+  pred = nullptr;
+  EXPECT_TRUE(pred.empty());
+}
@@ -211,3 +211,45 @@ TYPED_TEST(AllSingleMoveAssignConstructTests, AcceptClassMethodPointers)
 
   EXPECT_TRUE(left(&my_class));*/
 }
+
+namespace {
+  /// Functor which returns its own address
+  template<std::size_t Size, std::size_t Alignment>
+  struct AddressProvider
+  {
+    alignas(Alignment) unsigned char data[Size];
+
+    void const* operator()() const
+    {
+      return this;
+    }
+  };
+}
+
+TEST(storage_tests, AreStoringPointerSizedCapturesInplace)
+{
+  // Functions without an inline pointer to the target use
+  // the whole object besides the vtable as capacity.
+  using capture_t = AddressProvider<sizeof(fu2::function<void()>) -
+                                    sizeof(void*), alignof(void*)>;
+
+  fu2::function<void const*()> left = capture_t{};
+  void const* const address = left();
+  fu2::function<void const*()> right = std::move(left);
+  EXPECT_NE(right(), address);
+
+  auto const begin = reinterpret_cast<std::uintptr_t>(&right);
+  auto const target = reinterpret_cast<std::uintptr_t>(right());
+  EXPECT_GE(target, begin);
+  EXPECT_LT(target, begin + sizeof(right));
+}
+
+TEST(storage_tests, AreAligningOverAlignedCaptures)
+{
+  fu2::function<void const*()> left = AddressProvider<8, 16>{};
+  auto const address = reinterpret_cast<std::uintptr_t>(left());
+  EXPECT_EQ(address % 16, 0U);
+
+  fu2::function<void const*()> right = left;
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(right()) % 16, 0U);
+}
@@ -0,0 +1,171 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "function2/future.hpp"
+#include "function2-test.hpp"
+
+TEST(future_tests, are_continued_after_fulfillment)
+{
+  fu2::promise<int> promise;
+  auto future = promise.get_future();
+  EXPECT_FALSE(future.is_ready());
+
+  int result = 0;
+  future.subscribe([&](int value) { result = value; });
+  EXPECT_FALSE(future.valid());
+  EXPECT_EQ(result, 0);
+
+  promise.set_value(42);
+  EXPECT_EQ(result, 42);
+}
+
+TEST(future_tests, are_continued_when_fulfilled_already)
+{
+  fu2::promise<std::string> promise;
+  promise.set_value("value");
+  auto future = promise.get_future();
+  EXPECT_TRUE(future.is_ready());
+
+  std::string result;
+  future.subscribe([&](std::string value) { result = std::move(value); });
+  EXPECT_EQ(result, "value");
+}
+
+TEST(future_tests, are_chainable)
+{
+  fu2::promise<int> promise;
+  auto future = promise.get_future()
+    .then([](int value) { return value * 2; })
+    .then([](int value) { return std::to_string(value); });
+
+  promise.set_value(21);
+  EXPECT_TRUE(future.is_ready());
+  EXPECT_EQ(future.get(), "42");
+}
+
+TEST(future_tests, are_chainable_with_void)
+{
+  int calls = 0;
+  fu2::promise<void> promise;
+  auto future = promise.get_future()
+    .then([&] { ++calls; })
+    .then([&] { return ++calls; });
+
+  promise.set_value();
+  EXPECT_EQ(future.get(), 2);
+}
+
+TEST(future_tests, are_move_only)
+{
+  fu2::promise<std::unique_ptr<int>> promise;
+  auto future = promise.get_future();
+  promise.set_value(make_unique<int>(7));
+  EXPECT_EQ(*future.get(), 7);
+}
+
+TEST(future_tests, are_breaking_continuations)
+{
+  bool is_invoked = false;
+  fu2::future<int> next;
+  {
+    fu2::promise<int> promise;
+    next = promise.get_future().then([&](int value) {
+      is_invoked = true;
+      return value;
+    });
+  }
+  EXPECT_FALSE(is_invoked);
+  EXPECT_TRUE(next.is_ready());
+
+  bool is_next_invoked = false;
+  next.subscribe([&](int) { is_next_invoked = true; });
+  EXPECT_FALSE(is_next_invoked);
+}
+
+TEST(future_tests, are_fulfilled_from_other_threads)
+{
+  for (int i = 0; i < 100; ++i) {
+    fu2::promise<int> promise;
+    auto future = promise.get_future().then([](int value) {
+      return value + 1;
+    });
+
+    std::thread producer([&] { promise.set_value(i); });
+    EXPECT_EQ(future.get(), i + 1);
+    producer.join();
+  }
+}
+
+TEST(future_tests, are_blocking_until_fulfilled)
+{
+  fu2::promise<int> promise;
+  auto future = promise.get_future();
+
+  // The value is set long after the future stopped spinning
+  std::thread producer([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    promise.set_value(7);
+  });
+  EXPECT_EQ(future.get(), 7);
+  producer.join();
+}
+
+TEST(future_tests, are_combined_by_when_all)
+{
+  std::vector<fu2::promise<int>> promises(3);
+  std::vector<fu2::future<int>> futures;
+  for (auto& promise : promises) {
+    futures.push_back(promise.get_future());
+  }
+
+  auto all = fu2::when_all(std::move(futures));
+  promises[2].set_value(3);
+  promises[0].set_value(1);
+  EXPECT_FALSE(all.is_ready());
+  promises[1].set_value(2);
+  ASSERT_TRUE(all.is_ready());
+  EXPECT_EQ(all.get(), (std::vector<int>{1, 2, 3}));
+}
+
+TEST(future_tests, are_broken_by_when_all)
+{
+  std::vector<fu2::promise<std::string>> promises(2);
+  std::vector<fu2::future<std::string>> futures;
+  for (auto& promise : promises) {
+    futures.push_back(promise.get_future());
+  }
+
+  bool is_invoked = false;
+  fu2::when_all(std::move(futures))
+    .subscribe([&](std::vector<std::string>) { is_invoked = true; });
+  promises[0].set_value("first");
+  promises[1] = fu2::promise<std::string>();
+  EXPECT_FALSE(is_invoked);
+}
+
+TEST(future_tests, are_combined_by_when_any)
+{
+  std::vector<fu2::promise<int>> promises(3);
+  std::vector<fu2::future<int>> futures;
+  for (auto& promise : promises) {
+    futures.push_back(promise.get_future());
+  }
+
+  auto any = fu2::when_any(std::move(futures));
+  promises[1] = fu2::promise<int>();
+  EXPECT_FALSE(any.is_ready());
+  promises[2].set_value(3);
+  promises[0].set_value(1);
+
+  auto const result = any.get();
+  EXPECT_EQ(result.first, 2U);
+  EXPECT_EQ(result.second, 3);
+}
@@ -0,0 +1,151 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include "function2/instrumentation.hpp"
+#include "function2-test.hpp"
+
+namespace {
+  struct NamedTag {
+    static char const* name() { return "named"; }
+  };
+
+  struct UnnamedTag { };
+
+  struct ThreadedTag { };
+
+  struct PublishedTag {
+    static char const* name() { return "published"; }
+  };
+
+  template<typename Tag, std::size_t SampleRate>
+  using instrumented_t = fu2::function_base<
+    int(int), true, fu2::detail::default_capacity::value, true, false,
+    fu2::sampled_instrumentation<Tag, SampleRate>
+  >;
+
+  struct Increment {
+    int operator() (int i) const {
+      return i + 1;
+    }
+  };
+
+  /// Returns the histogram of the given tag and target type
+  template<typename Tag, typename Target>
+  fu2::instrumentation_histogram find() {
+    for (auto const& current : fu2::instrumentation_snapshot()) {
+      if ((current.tag == fu2::type_id_of<Tag>()) &&
+          (current.target == fu2::type_id_of<Target>()))
+        return current;
+    }
+    return fu2::instrumentation_histogram{
+      fu2::type_id_of<void>(), fu2::type_id_of<void>(), nullptr, 0U, 0U, {{}}};
+  }
+}
+
+TEST(instrumentation_tests, are_not_changing_the_size)
+{
+  EXPECT_EQ(sizeof(fu2::function<int(int)>),
+            sizeof(instrumented_t<NamedTag, 1>));
+}
+
+TEST(instrumentation_tests, are_sampling_every_nth_invocation)
+{
+  instrumented_t<NamedTag, 4> fn = Increment{};
+  auto const before = find<NamedTag, Increment>().samples;
+
+  int sum = 0;
+  for (int i = 0; i < 100; ++i) {
+    sum += fn(i);
+  }
+  EXPECT_EQ(sum, 5050);
+
+  auto const histogram = find<NamedTag, Increment>();
+  EXPECT_EQ(histogram.samples - before, 25U);
+  EXPECT_STREQ(histogram.name, "named");
+
+  std::uint64_t bucketed = 0U;
+  for (auto bucket : histogram.buckets) {
+    bucketed += bucket;
+  }
+  EXPECT_EQ(bucketed, histogram.samples);
+  EXPECT_GE(histogram.percentile(0.99), histogram.percentile(0.5));
+}
+
+TEST(instrumentation_tests, are_keyed_by_target_type)
+{
+  auto lambda = [](int i) { return i * 2; };
+  instrumented_t<UnnamedTag, 1> fn = lambda;
+  EXPECT_EQ(fn(2), 4);
+  fn = Increment{};
+  EXPECT_EQ(fn(2), 3);
+
+  auto const lambda_histogram = find<UnnamedTag, decltype(lambda)>();
+  auto const functor_histogram = find<UnnamedTag, Increment>();
+  EXPECT_EQ(lambda_histogram.samples, 1U);
+  EXPECT_EQ(functor_histogram.samples, 1U);
+  EXPECT_EQ(functor_histogram.name, nullptr);
+}
+
+TEST(instrumentation_tests, are_assignable_from_plain_functions)
+{
+  fu2::function<int(int)> plain = Increment{};
+  instrumented_t<NamedTag, 1> fn = std::move(plain);
+  EXPECT_EQ(fn(1), 2);
+}
+
+TEST(instrumentation_tests, are_merging_threads)
+{
+  auto const before = find<ThreadedTag, Increment>().samples;
+
+  std::thread threads[2];
+  for (auto& thread : threads) {
+    thread = std::thread([] {
+      instrumented_t<ThreadedTag, 2> fn = Increment{};
+      for (int i = 0; i < 10; ++i) {
+        fn(i);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  auto const after = find<ThreadedTag, Increment>().samples;
+  EXPECT_EQ(after - before, 10U);
+}
+
+TEST(instrumentation_tests, are_dumpable)
+{
+  instrumented_t<NamedTag, 1> fn = Increment{};
+  fn(0);
+
+  std::ostringstream stream;
+  fu2::dump_instrumentation(stream);
+  EXPECT_NE(stream.str().find("named (target "), std::string::npos);
+  EXPECT_NE(stream.str().find("<unnamed>"), std::string::npos);
+}
+
+TEST(instrumentation_tests, are_skipping_histograms_without_samples)
+{
+  using fu2::detail::instrumentation::registry;
+
+  // Publishes a histogram like a thread which didn't count its first
+  // sample yet.
+  for (auto& current : registry<>::local_record().histograms) {
+    if (!current.tag.load()) {
+      current.name.store(PublishedTag::name());
+      current.tag.store(&fu2::detail::type_id_tag<PublishedTag>::id);
+      break;
+    }
+  }
+
+  std::ostringstream stream;
+  fu2::dump_instrumentation(stream);
+  EXPECT_EQ(stream.str().find("published"), std::string::npos);
+}
@@ -0,0 +1,193 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include "function2/memoized.hpp"
+#include "function2-test.hpp"
+
+namespace {
+  /// A result whose assignment throws while the flag is set
+  struct Fragile
+  {
+    static bool is_throwing;
+
+    int value;
+
+    Fragile(int value_) : value(value_) { }
+    Fragile(Fragile const&) = default;
+
+    Fragile& operator= (Fragile const& right)
+    {
+      if (is_throwing)
+        throw std::runtime_error("assignment failed");
+      value = right.value;
+      return *this;
+    }
+  };
+
+  bool Fragile::is_throwing = false;
+}
+
+TEST(memoized_tests, are_caching_results)
+{
+  int calls = 0;
+  fu2::memoized<int(int)> square([&](int value) {
+    ++calls;
+    return value * value;
+  });
+
+  EXPECT_EQ(square(3), 9);
+  EXPECT_EQ(square(3), 9);
+  EXPECT_EQ(square(4), 16);
+  EXPECT_EQ(calls, 2);
+  EXPECT_EQ(square.size(), 2U);
+
+  square.clear();
+  EXPECT_EQ(square(3), 9);
+  EXPECT_EQ(calls, 3);
+}
+
+TEST(memoized_tests, are_keyed_by_all_arguments)
+{
+  int calls = 0;
+  fu2::memoized<std::string(std::string const&, int)> repeat(
+    [&](std::string const& value, int count) {
+      ++calls;
+      std::string result;
+      for (int i = 0; i < count; ++i) {
+        result += value;
+      }
+      return result;
+    });
+
+  EXPECT_EQ(repeat("ab", 2), "abab");
+  EXPECT_EQ(repeat("ab", 3), "ababab");
+  EXPECT_EQ(repeat("a", 2), "aa");
+  EXPECT_EQ(repeat(std::string("ab"), 2), "abab");
+  EXPECT_EQ(calls, 3);
+}
+
+TEST(memoized_tests, are_bounded)
+{
+  int calls = 0;
+  fu2::memoized<int(int)> identity([&](int value) {
+    ++calls;
+    return value;
+  }, 8);
+
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 100; ++i) {
+      EXPECT_EQ(identity(i), i);
+    }
+  }
+  EXPECT_EQ(identity.size(), 8U);
+  EXPECT_EQ(identity.capacity(), 8U);
+  EXPECT_EQ(calls, 300);
+}
+
+TEST(memoized_tests, are_evicting_in_clock_order)
+{
+  int calls = 0;
+  fu2::memoized<int(int)> identity([&](int value) {
+    ++calls;
+    return value;
+  }, 2);
+
+  identity(1);
+  identity(2);
+  // The hit gives the first result a second chance
+  identity(1);
+  identity(3);
+  EXPECT_EQ(calls, 3);
+
+  identity(1);
+  EXPECT_EQ(calls, 3);
+  identity(2);
+  EXPECT_EQ(calls, 4);
+}
+
+TEST(memoized_tests, are_invocable_recursively)
+{
+  int calls = 0;
+  fu2::memoized<unsigned long long(int)>* self = nullptr;
+  fu2::memoized<unsigned long long(int)> fibonacci([&](int n) {
+    ++calls;
+    return (n < 2) ? static_cast<unsigned long long>(n)
+                   : (*self)(n - 1) + (*self)(n - 2);
+  }, 64U);
+  self = &fibonacci;
+
+  // Every result is computed once and cached besides the nested ones
+  EXPECT_EQ(fibonacci(40), 102334155ULL);
+  EXPECT_EQ(calls, 41);
+  EXPECT_EQ(fibonacci.size(), 41U);
+}
+
+#ifndef TESTS_NO_EXCEPTIONS
+TEST(memoized_tests, are_usable_after_an_eviction_threw)
+{
+  int calls = 0;
+  fu2::memoized<Fragile(int)> identity([&](int value) {
+    ++calls;
+    return Fragile(value);
+  }, 2);
+
+  identity(1);
+  identity(2);
+  Fragile::is_throwing = true;
+  EXPECT_THROW(identity(3), std::runtime_error);
+  Fragile::is_throwing = false;
+  EXPECT_EQ(calls, 3);
+
+  // The entry which failed to be replaced is reused by the next eviction
+  for (int round = 0; round < 2; ++round) {
+    for (int i = 1; i <= 4; ++i) {
+      EXPECT_EQ(identity(i).value, i);
+    }
+  }
+  EXPECT_EQ(identity.size(), 2U);
+}
+#endif // TESTS_NO_EXCEPTIONS
+
+TEST(memoized_tests, are_storing_move_only_functors)
+{
+  auto offset = make_unique<int>(10);
+  fu2::memoized<int(int)> add([offset = std::move(offset)](int value) {
+    return value + *offset;
+  });
+  EXPECT_EQ(add(1), 11);
+}
+
+TEST(memoized_tests, are_invocable_concurrently)
+{
+  std::atomic<int> calls(0);
+  fu2::concurrent_memoized<long(int)> cube([&](int value) {
+    calls.fetch_add(1, std::memory_order_relaxed);
+    return static_cast<long>(value) * value * value;
+  }, 256, 4);
+
+  std::thread threads[4];
+  for (auto& thread : threads) {
+    thread = std::thread([&] {
+      for (int round = 0; round < 10; ++round) {
+        for (int i = 0; i < 32; ++i) {
+          EXPECT_EQ(cube(i), static_cast<long>(i) * i * i);
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(cube.size(), 32U);
+  // Concurrent misses of the same arguments might invoke the functor twice
+  EXPECT_GE(calls.load(), 32);
+  EXPECT_LE(calls.load(), 32 * 4);
+}
@@ -0,0 +1,254 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+#include <vector>
+#include "function2-test.hpp"
+
+namespace {
+  /// The copies and moves of a counting functor
+  struct Counts
+  {
+    std::size_t copies = 0UL;
+    std::size_t moves = 0UL;
+  };
+
+  /// Functor which counts its copies and moves
+  class CountingFunctor
+  {
+    Counts* counts_;
+
+  public:
+    explicit CountingFunctor(Counts& counts) : counts_(&counts) { }
+
+    CountingFunctor(CountingFunctor const& right) : counts_(right.counts_)
+    {
+      ++counts_->copies;
+    }
+
+    CountingFunctor(CountingFunctor&& right) : counts_(right.counts_)
+    {
+      ++counts_->moves;
+    }
+
+    CountingFunctor& operator= (CountingFunctor const&) = delete;
+    CountingFunctor& operator= (CountingFunctor&&) = delete;
+
+    bool operator() () const
+    {
+      return true;
+    }
+  };
+
+  /// Functor which counts its copies and moves, its moves never throw
+  class NothrowCountingFunctor
+  {
+    Counts* counts_;
+
+  public:
+    explicit NothrowCountingFunctor(Counts& counts) : counts_(&counts) { }
+
+    NothrowCountingFunctor(NothrowCountingFunctor const& right)
+      : counts_(right.counts_)
+    {
+      ++counts_->copies;
+    }
+
+    NothrowCountingFunctor(NothrowCountingFunctor&& right) noexcept
+      : counts_(right.counts_)
+    {
+      ++counts_->moves;
+    }
+
+    NothrowCountingFunctor& operator= (NothrowCountingFunctor const&) = delete;
+    NothrowCountingFunctor& operator= (NothrowCountingFunctor&&) = delete;
+
+    bool operator() () const
+    {
+      return true;
+    }
+  };
+
+  /// Functor which replaces itself through its next functor on invocation
+  template<typename Function>
+  class SelfReplacingFunctor
+  {
+    Function* self_;
+    NothrowCountingFunctor next_;
+
+  public:
+    SelfReplacingFunctor(Function& self, Counts& counts)
+      : self_(&self), next_(counts) { }
+
+    bool operator() ()
+    {
+      // The functor is destroyed through the assignment
+      Function* const self = self_;
+      *self = std::move(next_);
+      return false;
+    }
+  };
+
+  /// Grows a vector of functions which store the given functor
+  /// well beyond its initial capacity.
+  template<typename Function, typename Functor>
+  void growVector(Counts& counts)
+  {
+    std::vector<Function> functions;
+    for (std::size_t i = 0UL; i < 100UL; ++i)
+      functions.push_back(Function(Functor(counts)));
+
+    for (auto& function : functions)
+      EXPECT_TRUE(function());
+  }
+}
+
+ALL_LEFT_TYPED_TEST_CASE(AllMoveCountTests)
+
+TYPED_TEST(AllMoveCountTests, AreMovingOnceOnConstructFromRValue)
+{
+  Counts counts;
+  typename TestFixture::template left_t<bool()> left =
+    CountingFunctor(counts);
+  EXPECT_TRUE(left());
+  EXPECT_EQ(counts.copies, 0UL);
+  EXPECT_EQ(counts.moves, 1UL);
+}
+
+TYPED_TEST(AllMoveCountTests, AreCopyingOnceOnConstructFromLValue)
+{
+  Counts counts;
+  CountingFunctor const functor(counts);
+  typename TestFixture::template left_t<bool()> left = functor;
+  EXPECT_TRUE(left());
+  EXPECT_EQ(counts.copies, 1UL);
+  EXPECT_EQ(counts.moves, 0UL);
+}
+
+TYPED_TEST(AllMoveCountTests, AreMovingOnceOnAssignFromRValue)
+{
+  Counts counts;
+  typename TestFixture::template left_t<bool()> left;
+  left = CountingFunctor(counts);
+  EXPECT_TRUE(left());
+  EXPECT_EQ(counts.copies, 0UL);
+  EXPECT_EQ(counts.moves, 1UL);
+}
+
+TYPED_TEST(AllMoveCountTests, AreCopyingOnceOnAssignFromLValue)
+{
+  Counts counts;
+  CountingFunctor functor(counts);
+  typename TestFixture::template left_t<bool()> left = returnTrue;
+  left = functor;
+  EXPECT_TRUE(left());
+  EXPECT_EQ(counts.copies, 1UL);
+  EXPECT_EQ(counts.moves, 0UL);
+}
+
+TYPED_TEST(AllMoveCountTests, AreMovingOnceOnAllocatorAssign)
+{
+  Counts counts;
+  typename TestFixture::template left_t<bool()> left;
+  left.assign(CountingFunctor(counts), std::allocator<CountingFunctor>{});
+  EXPECT_TRUE(left());
+  EXPECT_EQ(counts.copies, 0UL);
+  EXPECT_EQ(counts.moves, 1UL);
+
+  CountingFunctor const functor(counts);
+  left.assign(functor, std::allocator<CountingFunctor>{});
+  EXPECT_EQ(counts.copies, 1UL);
+  EXPECT_EQ(counts.moves, 1UL);
+}
+
+TYPED_TEST(AllMoveCountTests, AreNeverCopyingOrMovingOnEmplace)
+{
+  Counts counts;
+  typename TestFixture::template left_t<bool()> left(
+    fu2::in_place_type_t<CountingFunctor>{}, counts);
+  left.template emplace<CountingFunctor>(counts);
+  EXPECT_TRUE(left());
+  EXPECT_EQ(counts.copies, 0UL);
+  EXPECT_EQ(counts.moves, 0UL);
+}
+
+TYPED_TEST(AllMoveCountTests, AreMovingAtMostOnceOnMove)
+{
+  Counts counts;
+  typename TestFixture::template left_t<bool()> left =
+    CountingFunctor(counts);
+  counts = Counts{};
+
+  // Heap allocated functors aren't moved at all
+  typename TestFixture::template left_t<bool()> right(std::move(left));
+  EXPECT_TRUE(right());
+  EXPECT_EQ(counts.copies, 0UL);
+  EXPECT_LE(counts.moves, 1UL);
+
+  counts = Counts{};
+  left = std::move(right);
+  EXPECT_TRUE(left());
+  EXPECT_EQ(counts.copies, 0UL);
+  EXPECT_LE(counts.moves, 1UL);
+}
+
+TYPED_TEST(AllMoveCountTests, AreNothrowMovable)
+{
+  using left_t = typename TestFixture::template left_t<bool()>;
+  EXPECT_TRUE(std::is_nothrow_move_constructible<left_t>::value);
+  EXPECT_TRUE(std::is_nothrow_move_assignable<left_t>::value);
+}
+
+TYPED_TEST(AllMoveCountTests, AreNeverCopyingOnVectorGrowth)
+{
+  using left_t = typename TestFixture::template left_t<bool()>;
+
+  // Functors with a throwing move are heap allocated
+  Counts counts;
+  growVector<left_t, CountingFunctor>(counts);
+  EXPECT_EQ(counts.copies, 0UL);
+
+  counts = Counts{};
+  growVector<left_t, NothrowCountingFunctor>(counts);
+  EXPECT_EQ(counts.copies, 0UL);
+}
+
+TYPED_TEST(AllMoveCountTests, AreReplaceableFromInsideTheirTarget)
+{
+  using left_t = typename TestFixture::template left_t<bool()>;
+
+  Counts counts;
+  left_t left;
+  left = SelfReplacingFunctor<left_t>(left, counts);
+  counts = Counts{};
+
+  // The next functor is moved out of the replaced target before
+  // the target is destroyed.
+  EXPECT_FALSE(left());
+  EXPECT_TRUE(left());
+  EXPECT_EQ(counts.copies, 0UL);
+  EXPECT_LE(counts.moves, 2UL);
+}
+
+COPYABLE_LEFT_TYPED_TEST_CASE(AllCopyCountTests)
+
+TYPED_TEST(AllCopyCountTests, AreCopyingOnceOnCopy)
+{
+  Counts counts;
+  typename TestFixture::template left_t<bool()> left =
+    CountingFunctor(counts);
+  counts = Counts{};
+
+  typename TestFixture::template left_t<bool()> right(left);
+  EXPECT_TRUE(right());
+  EXPECT_EQ(counts.copies, 1UL);
+  EXPECT_EQ(counts.moves, 0UL);
+
+  counts = Counts{};
+  right = left;
+  EXPECT_TRUE(right());
+  EXPECT_EQ(counts.copies, 1UL);
+  EXPECT_EQ(counts.moves, 0UL);
+}
@@ -0,0 +1,211 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+#include <array>
+#include <cstddef>
+#include <type_traits>
+#include "function2-test.hpp"
+
+namespace {
+  /// The moves and destructions of a counting functor
+  struct Counts
+  {
+    std::size_t moves = 0UL;
+    std::size_t destructions = 0UL;
+  };
+
+  /// Functor which counts its moves and destructions,
+  /// the tag selects whether it is trivially relocatable.
+  template<typename Tag>
+  class CountingFunctor
+  {
+    Counts* counts_;
+    int value_;
+
+  public:
+    CountingFunctor(Counts& counts, int value)
+      : counts_(&counts), value_(value) { }
+
+    CountingFunctor(CountingFunctor&& right) noexcept
+      : counts_(right.counts_), value_(right.value_)
+    {
+      ++counts_->moves;
+    }
+
+    CountingFunctor& operator= (CountingFunctor&&) = delete;
+
+    ~CountingFunctor()
+    {
+      ++counts_->destructions;
+    }
+
+    int operator() () const
+    {
+      return value_;
+    }
+  };
+
+  /// A functor which isn't relocatable
+  struct Unrelocatable { };
+  /// A functor which opts into trivial relocation
+  struct Relocatable { };
+
+  /// Uninitialized storage for the given count of functions
+  template<typename Function, std::size_t Count>
+  class Buffer
+  {
+    typename std::aligned_storage<
+      sizeof(Function), std::alignment_of<Function>::value
+    >::type storage_[Count];
+
+  public:
+    Function* at(std::size_t index)
+    {
+      return reinterpret_cast<Function*>(&storage_[index]);
+    }
+  };
+
+  /// Constructs the functions inside the given buffer,
+  /// every function returns its index.
+  template<typename Functor, typename Function, std::size_t Count>
+  void construct(Buffer<Function, Count>& buffer, Counts& counts,
+                 std::size_t first, std::size_t last)
+  {
+    for (std::size_t i = first; i != last; ++i)
+      new (buffer.at(i)) Function(fu2::in_place_type_t<Functor>{},
+                                  counts, static_cast<int>(i - first));
+  }
+
+  template<typename Function, std::size_t Count>
+  void destroy(Buffer<Function, Count>& buffer, std::size_t first,
+               std::size_t last)
+  {
+    for (std::size_t i = first; i != last; ++i)
+      buffer.at(i)->~Function();
+  }
+}
+
+namespace fu2 {
+template<>
+struct is_trivially_relocatable<CountingFunctor<Relocatable>>
+  : std::true_type { };
+}
+
+TEST(relocate_tests, relocate_trivially_relocatable_targets_by_copying)
+{
+  using function_t = fu2::unique_function<int()>;
+
+  Counts counts;
+  Buffer<function_t, 8> buffer;
+  construct<CountingFunctor<Relocatable>>(buffer, counts, 0UL, 4UL);
+  EXPECT_TRUE(buffer.at(0)->is_trivially_relocatable());
+
+  function_t* const end = fu2::relocate(buffer.at(0), buffer.at(4),
+                                        buffer.at(4));
+  EXPECT_EQ(end, buffer.at(8));
+  EXPECT_EQ(counts.moves, 0UL);
+  EXPECT_EQ(counts.destructions, 0UL);
+
+  for (std::size_t i = 0UL; i != 4UL; ++i)
+    EXPECT_EQ((*buffer.at(4UL + i))(), static_cast<int>(i));
+
+  destroy(buffer, 4UL, 8UL);
+  EXPECT_EQ(counts.destructions, 4UL);
+}
+
+TEST(relocate_tests, relocate_heap_allocated_targets_by_copying)
+{
+  using function_t = fu2::function_base<int(), false, 0UL>;
+
+  Counts counts;
+  Buffer<function_t, 8> buffer;
+  construct<CountingFunctor<Unrelocatable>>(buffer, counts, 0UL, 4UL);
+  EXPECT_TRUE(buffer.at(0)->is_trivially_relocatable());
+
+  fu2::relocate(buffer.at(0), buffer.at(4), buffer.at(4));
+  EXPECT_EQ(counts.moves, 0UL);
+  EXPECT_EQ(counts.destructions, 0UL);
+
+  for (std::size_t i = 0UL; i != 4UL; ++i)
+    EXPECT_EQ((*buffer.at(4UL + i))(), static_cast<int>(i));
+
+  destroy(buffer, 4UL, 8UL);
+  EXPECT_EQ(counts.destructions, 4UL);
+}
+
+TEST(relocate_tests, relocate_other_in_place_targets_by_moving)
+{
+  using function_t = fu2::unique_function<int()>;
+
+  Counts counts;
+  Buffer<function_t, 8> buffer;
+  construct<CountingFunctor<Unrelocatable>>(buffer, counts, 0UL, 3UL);
+  new (buffer.at(3)) function_t();
+  EXPECT_FALSE(buffer.at(0)->is_trivially_relocatable());
+  EXPECT_TRUE(buffer.at(3)->is_trivially_relocatable());
+
+  fu2::relocate(buffer.at(0), buffer.at(4), buffer.at(4));
+  EXPECT_EQ(counts.moves, 3UL);
+  EXPECT_EQ(counts.destructions, 3UL);
+
+  for (std::size_t i = 0UL; i != 3UL; ++i)
+    EXPECT_EQ((*buffer.at(4UL + i))(), static_cast<int>(i));
+  EXPECT_TRUE(buffer.at(7)->empty());
+
+  destroy(buffer, 4UL, 8UL);
+  EXPECT_EQ(counts.destructions, 6UL);
+}
+
+TEST(relocate_tests, relocate_overlapping_ranges)
+{
+  using function_t = fu2::unique_function<int()>;
+
+  Counts counts;
+  Buffer<function_t, 6> buffer;
+
+  // Shifts the functions to the back and to the front again,
+  // like inserting into and erasing from a container.
+  construct<CountingFunctor<Unrelocatable>>(buffer, counts, 0UL, 4UL);
+  fu2::relocate(buffer.at(0), buffer.at(4), buffer.at(2));
+  for (std::size_t i = 0UL; i != 4UL; ++i)
+    EXPECT_EQ((*buffer.at(2UL + i))(), static_cast<int>(i));
+
+  fu2::relocate(buffer.at(2), buffer.at(6), buffer.at(1));
+  for (std::size_t i = 0UL; i != 4UL; ++i)
+    EXPECT_EQ((*buffer.at(1UL + i))(), static_cast<int>(i));
+  destroy(buffer, 1UL, 5UL);
+
+  construct<CountingFunctor<Relocatable>>(buffer, counts, 0UL, 4UL);
+  fu2::relocate(buffer.at(0), buffer.at(4), buffer.at(1));
+  fu2::relocate(buffer.at(1), buffer.at(5), buffer.at(0));
+  for (std::size_t i = 0UL; i != 4UL; ++i)
+    EXPECT_EQ((*buffer.at(i))(), static_cast<int>(i));
+  destroy(buffer, 0UL, 4UL);
+
+  EXPECT_EQ(counts.destructions - counts.moves, 8UL);
+}
+
+TEST(relocate_tests, are_trivially_relocatable_for_library_targets)
+{
+  fu2::unique_function<int(int)> fn;
+  EXPECT_TRUE(fn.is_trivially_relocatable());
+
+  fn = static_cast<int(*)(int)>([](int value) { return value; });
+  EXPECT_TRUE(fn.is_trivially_relocatable());
+
+  // Heap allocated targets are adopted as a pointer to the heap
+  std::array<int, 4> const values{{1, 2, 3, 4}};
+  fu2::function_base<int(int), false, 0UL> heap = [values](int value) {
+    return value + values[0];
+  };
+  fu2::unique_function<long(int)> adopted = std::move(heap);
+  EXPECT_TRUE(adopted.is_trivially_relocatable());
+  EXPECT_EQ(adopted(3), 4L);
+
+  fu2::compact_unique_function<int(int)> compact =
+    [values](int) { return values[1]; };
+  EXPECT_TRUE(compact.is_trivially_relocatable());
+}
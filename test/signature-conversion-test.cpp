@@ -0,0 +1,234 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+#include <memory>
+#include <stdexcept>
+#include "function2-test.hpp"
+
+namespace {
+  /// Coroutine which increases it's return value by every call
+  class IncreasingCoroutine
+  {
+    int state = 0;
+
+  public:
+    int operator() (int step)
+    {
+      return state += step;
+    }
+  };
+
+  /// Functor which records its address on every call
+  class AddressRecorder
+  {
+    void const** address_;
+
+  public:
+    explicit AddressRecorder(void const*& address) : address_(&address) { }
+
+    int operator() () const
+    {
+      *address_ = this;
+      return 7;
+    }
+  };
+
+  /// Returns true when the functor which recorded the given address
+  /// is stored inside the given function.
+  template<typename Function>
+  bool isStoredInside(Function const& function, void const* address)
+  {
+    auto const first = reinterpret_cast<char const*>(&function);
+    auto const current = static_cast<char const*>(address);
+    return (first <= current) && (current < first + sizeof(Function));
+  }
+
+  /// Functor which throws on copy when its flag is set
+  class ThrowingCopy
+  {
+    bool const* throws_;
+
+  public:
+    explicit ThrowingCopy(bool const& throws) : throws_(&throws) { }
+
+    ThrowingCopy(ThrowingCopy const& right) : throws_(right.throws_)
+    {
+      if (*throws_)
+        throw std::runtime_error("copy");
+    }
+
+    ThrowingCopy(ThrowingCopy&& right) noexcept : throws_(right.throws_) { }
+
+    int operator() () const
+    {
+      return 7;
+    }
+  };
+}
+
+ALL_LEFT_RIGHT_TYPED_TEST_CASE(AllSignatureConversionTests)
+
+TYPED_TEST(AllSignatureConversionTests, AreConvertibleToOtherReturnTypes)
+{
+  typename TestFixture::template right_t<int(int)> right = [](int i) {
+    return i + 1;
+  };
+  typename TestFixture::template left_t<long(int)> left(std::move(right));
+  EXPECT_TRUE(left);
+  EXPECT_EQ(left(1), 2L);
+}
+
+TYPED_TEST(AllSignatureConversionTests, AreConvertibleToVoidReturnTypes)
+{
+  int calls = 0;
+  typename TestFixture::template right_t<int(int)> right = [&](int i) {
+    return calls += i;
+  };
+  typename TestFixture::template left_t<void(int)> left;
+  left = std::move(right);
+  left(2);
+  left(3);
+  EXPECT_EQ(calls, 5);
+}
+
+TYPED_TEST(AllSignatureConversionTests, TransferStatesOnConversion)
+{
+  typename TestFixture::template right_t<int(int)> right =
+    IncreasingCoroutine();
+  EXPECT_EQ(right(1), 1);
+  EXPECT_EQ(right(1), 2);
+  typename TestFixture::template left_t<long(short)> left(std::move(right));
+  EXPECT_EQ(left(1), 3L);
+  EXPECT_EQ(left(2), 5L);
+}
+
+TYPED_TEST(AllSignatureConversionTests, AreFreeingTheAdoptedTarget)
+{
+  auto const state = std::make_shared<int>(3);
+  {
+    typename TestFixture::template right_t<int(int)> right = [state](int i) {
+      return *state + i;
+    };
+    EXPECT_EQ(state.use_count(), 2L);
+    typename TestFixture::template left_t<long(int)> left(std::move(right));
+    EXPECT_EQ(left(1), 4L);
+    left = nullptr;
+    EXPECT_EQ(state.use_count(), 1L);
+  }
+  EXPECT_EQ(state.use_count(), 1L);
+}
+
+COPYABLE_LEFT_RIGHT_TYPED_TEST_CASE(CopyableSignatureConversionTests)
+
+TYPED_TEST(CopyableSignatureConversionTests, CopyStateOnConversion)
+{
+  typename TestFixture::template right_t<int(int)> right =
+    IncreasingCoroutine();
+  EXPECT_EQ(right(1), 1);
+  typename TestFixture::template left_t<long(int)> left(right);
+  EXPECT_EQ(left(1), 2L);
+  EXPECT_EQ(right(1), 2);
+  left = right;
+  EXPECT_EQ(left(1), 3L);
+  EXPECT_EQ(right(1), 3);
+}
+
+TYPED_TEST(CopyableSignatureConversionTests, AreCopyableAfterConversion)
+{
+  typename TestFixture::template right_t<int(int)> right =
+    IncreasingCoroutine();
+  typename TestFixture::template left_t<long(int)> left(right);
+  EXPECT_EQ(left(1), 1L);
+  auto copy = left;
+  EXPECT_EQ(copy(1), 2L);
+  EXPECT_EQ(left(1), 2L);
+}
+
+TEST(signature_conversion_tests, are_convertible_to_other_qualifiers)
+{
+  fu2::function<int() const> right = [] {
+    return 7;
+  };
+  fu2::unique_function<long()&&> left(std::move(right));
+  EXPECT_EQ(std::move(left)(), 7L);
+}
+
+TEST(signature_conversion_tests, adopt_small_targets_without_allocation)
+{
+  void const* address = nullptr;
+  fu2::function<int() const> right = AddressRecorder(address);
+
+  // The adopted target is stored in-place, thus it isn't allocated
+  fu2::function<long()> copy(right);
+  EXPECT_EQ(copy(), 7L);
+  EXPECT_TRUE(isStoredInside(copy, address));
+
+  fu2::unique_function<long()> moved(std::move(right));
+  EXPECT_EQ(moved(), 7L);
+  EXPECT_TRUE(isStoredInside(moved, address));
+
+  // Targets which don't fit besides the vtable are adopted from the heap
+  fu2::function_base<long(), false, 2UL * sizeof(void*)> small(
+    std::move(copy));
+  EXPECT_EQ(small(), 7L);
+  EXPECT_FALSE(isStoredInside(small, address));
+}
+
+TEST(signature_conversion_tests, are_empty_when_converted_from_empty)
+{
+  fu2::function<int(int)> right;
+  fu2::unique_function<long(int)> left(std::move(right));
+  EXPECT_FALSE(left);
+  EXPECT_TRUE(left == nullptr);
+  fu2::function<void(int)> copy(right);
+  EXPECT_FALSE(copy);
+}
+
+TEST(signature_conversion_tests, reject_incompatible_signatures)
+{
+  using from_t = fu2::function<int(int) const>;
+  using from_mutable_t = fu2::function<int(int)>;
+  using from_rvalue_t = fu2::function<int(int)&&>;
+
+  EXPECT_TRUE((std::is_constructible<fu2::function<long(int)>, from_t>::value));
+  EXPECT_TRUE((std::is_constructible<
+    fu2::unique_function<void(int)&&>, from_t>::value));
+  EXPECT_FALSE((std::is_constructible<
+    fu2::function<int(std::string)>, from_t>::value));
+  EXPECT_FALSE((std::is_constructible<
+    fu2::function<long(int) const>, from_mutable_t>::value));
+  EXPECT_FALSE((std::is_constructible<
+    fu2::function<long(int)>, from_rvalue_t>::value));
+  EXPECT_FALSE((std::is_constructible<
+    fu2::function<long(int)>, fu2::unique_function<int(int)>>::value));
+}
+
+#ifndef TESTS_NO_EXCEPTIONS
+TEST(signature_conversion_tests, keep_the_target_when_the_copy_throws)
+{
+  bool throws = false;
+  fu2::function<int() const> right = ThrowingCopy(throws);
+  auto const state = std::make_shared<long>(1L);
+  fu2::function<long()> left = [state] {
+    return *state;
+  };
+
+  throws = true;
+  EXPECT_THROW(left = right, std::runtime_error);
+  EXPECT_EQ(left(), 1L);
+  EXPECT_EQ(state.use_count(), 2L);
+  EXPECT_THROW(fu2::function<long()>{right}, std::runtime_error);
+
+  throws = false;
+  left = right;
+  EXPECT_EQ(left(), 7L);
+
+  // Copies the adopted target
+  throws = true;
+  EXPECT_THROW(fu2::function<long()>{left}, std::runtime_error);
+  EXPECT_EQ(left(), 7L);
+}
+#endif // TESTS_NO_EXCEPTIONS
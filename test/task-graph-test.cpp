@@ -0,0 +1,129 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "function2/task_graph.hpp"
+#include "function2-test.hpp"
+
+TEST(task_graph_tests, are_running_empty_graphs)
+{
+  fu2::task_graph<> graph;
+  EXPECT_TRUE(graph.empty());
+  graph.run();
+
+  fu2::worker_pool pool(2U);
+  graph.run(pool);
+}
+
+TEST(task_graph_tests, are_invoking_tasks_after_their_predecessors)
+{
+  std::vector<int> order;
+  fu2::task_graph<> graph;
+  auto const last = graph.emplace([&] { order.push_back(3); });
+  auto const first = graph.emplace([&] { order.push_back(1); });
+  auto const second = graph.emplace([&] { order.push_back(2); });
+  graph.precede(first, second);
+  graph.precede(second, last);
+  EXPECT_EQ(graph.size(), 3UL);
+
+  graph.run();
+  EXPECT_EQ(order, (std::vector<int>{1, 2, 3}));
+}
+
+TEST(task_graph_tests, are_reusable)
+{
+  int calls = 0;
+  fu2::task_graph<> graph;
+  auto const first = graph.emplace([&] { ++calls; });
+  auto const second = graph.emplace([&] { calls *= 10; });
+  graph.precede(first, second);
+
+  graph.run();
+  graph.run();
+  EXPECT_EQ(calls, 110);
+
+  graph.clear();
+  EXPECT_TRUE(graph.empty());
+  graph.emplace([&] { calls = 0; });
+  graph.run();
+  EXPECT_EQ(calls, 0);
+}
+
+TEST(task_graph_tests, are_storing_tasks_inplace)
+{
+  auto state = make_unique<int>(7);
+  int result = 0;
+  fu2::task_graph<64> graph;
+  graph.emplace([&result, state = std::move(state)] { result = *state; });
+  graph.run();
+  EXPECT_EQ(result, 7);
+}
+
+TEST(task_graph_tests, are_joining_wide_fan_outs_on_workers)
+{
+  std::size_t const width = 64UL;
+  std::atomic<std::size_t> calls(0UL);
+  std::vector<std::size_t> visible(width, 0UL);
+  std::size_t joined = 0UL;
+
+  fu2::task_graph<> graph;
+  auto const source = graph.emplace([&] { calls.store(0UL); });
+  auto const sink = graph.emplace([&] { joined = calls.load(); });
+  for (std::size_t i = 0UL; i < width; ++i) {
+    auto const stage = graph.emplace([&, i] {
+      visible[i] = calls.fetch_add(1UL) + 1UL;
+    });
+    graph.precede(source, stage);
+    graph.precede(stage, sink);
+  }
+
+  fu2::worker_pool pool(3U);
+  EXPECT_EQ(pool.size(), 3UL);
+  for (int frame = 0; frame < 100; ++frame) {
+    graph.run(pool);
+    EXPECT_EQ(joined, width);
+  }
+}
+
+TEST(task_graph_tests, are_releasing_chains_on_workers)
+{
+  std::vector<int> values(32, 0);
+  fu2::task_graph<> graph;
+  auto previous = graph.emplace([&] { values[0] = 1; });
+  for (std::size_t i = 1UL; i < values.size(); ++i) {
+    auto const next = graph.emplace([&, i] { values[i] = values[i - 1] + 1; });
+    graph.precede(previous, next);
+    previous = next;
+  }
+
+  fu2::worker_pool pool(2U);
+  graph.run(pool);
+  EXPECT_EQ(values.back(), 32);
+}
+
+TEST(task_graph_tests, are_waking_blocked_workers_up)
+{
+  std::size_t const width = 16UL;
+  std::atomic<std::size_t> calls(0UL);
+
+  // The workers block long before the slow task releases its successors
+  fu2::task_graph<> graph;
+  auto const slow = graph.emplace([] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  });
+  for (std::size_t i = 0UL; i < width; ++i) {
+    graph.precede(slow, graph.emplace([&] { calls.fetch_add(1UL); }));
+  }
+
+  fu2::worker_pool pool(3U);
+  for (int frame = 0; frame < 3; ++frame) {
+    graph.run(pool);
+  }
+  EXPECT_EQ(calls.load(), 3UL * width);
+}
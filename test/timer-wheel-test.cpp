@@ -0,0 +1,201 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+#include "function2/timer_wheel.hpp"
+#include "function2-test.hpp"
+
+TEST(timer_wheel_tests, are_expiring_after_their_delay)
+{
+  std::vector<int> expired;
+  fu2::timer_wheel<> wheel;
+  wheel.schedule(3U, [&] { expired.push_back(3); });
+  wheel.schedule(1U, [&] { expired.push_back(1); });
+  wheel.schedule(0U, [&] { expired.push_back(0); });
+  EXPECT_EQ(wheel.size(), 3UL);
+
+  EXPECT_EQ(wheel.advance(), 2UL);
+  EXPECT_EQ(expired, (std::vector<int>{1, 0}));
+  EXPECT_EQ(wheel.advance(), 0UL);
+  EXPECT_EQ(wheel.advance(), 1UL);
+  EXPECT_EQ(expired, (std::vector<int>{1, 0, 3}));
+  EXPECT_TRUE(wheel.empty());
+  EXPECT_EQ(wheel.now(), 3U);
+}
+
+TEST(timer_wheel_tests, are_expiring_in_order_of_their_scheduling)
+{
+  std::vector<int> expired;
+  fu2::timer_wheel<> wheel;
+  // The first timer is cascaded into the slot of the second one
+  wheel.schedule(100U, [&] { expired.push_back(1); });
+  wheel.advance(50U);
+  wheel.schedule(50U, [&] { expired.push_back(2); });
+  wheel.advance(60U);
+  EXPECT_EQ(expired, (std::vector<int>{1, 2}));
+}
+
+TEST(timer_wheel_tests, are_expiring_in_order_across_cascades)
+{
+  std::mt19937_64 random(11U);
+  std::uint64_t const far = std::uint64_t(1) << 37U;
+
+  // Timers are scheduled at different times for a few shared ticks,
+  // thus timers of the same tick are linked into different wheels.
+  std::vector<std::uint64_t> ticks;
+  for (std::size_t i = 0UL; i < 64UL; ++i) {
+    ticks.push_back(1U + random() % 300000U);
+  }
+  ticks.push_back(far);
+  ticks.push_back(far + 1U);
+
+  fu2::timer_wheel<> wheel;
+  std::vector<std::pair<std::uint64_t, std::size_t>> scheduled;
+  std::vector<std::size_t> expired;
+  for (std::size_t round = 0UL; round < 100UL; ++round) {
+    for (std::size_t i = 0UL; i < 40UL; ++i) {
+      std::uint64_t const tick = ticks[random() % ticks.size()];
+      if (tick <= wheel.now())
+        continue;
+
+      std::size_t const sequence = scheduled.size();
+      scheduled.emplace_back(tick, sequence);
+      wheel.schedule(tick - wheel.now(),
+                     [&, sequence] { expired.push_back(sequence); });
+    }
+    wheel.advance(random() % 3000U);
+  }
+  wheel.advance(far + 1U - wheel.now());
+
+  std::sort(scheduled.begin(), scheduled.end());
+  std::vector<std::size_t> expected;
+  for (auto const& timer : scheduled) {
+    expected.push_back(timer.second);
+  }
+  EXPECT_EQ(expired, expected);
+  EXPECT_TRUE(wheel.empty());
+}
+
+TEST(timer_wheel_tests, are_cancellable)
+{
+  int calls = 0;
+  fu2::timer_wheel<> wheel;
+  auto const first = wheel.schedule(10U, [&] { calls += 1; });
+  auto const second = wheel.schedule(10U, [&] { calls += 10; });
+  EXPECT_TRUE(first);
+
+  EXPECT_TRUE(wheel.cancel(first));
+  EXPECT_FALSE(wheel.cancel(first));
+  EXPECT_EQ(wheel.size(), 1UL);
+
+  wheel.advance(10U);
+  EXPECT_EQ(calls, 10);
+  EXPECT_FALSE(wheel.cancel(second));
+  EXPECT_FALSE(wheel.cancel(decltype(first){}));
+}
+
+TEST(timer_wheel_tests, are_rejecting_outdated_handles)
+{
+  int calls = 0;
+  fu2::timer_wheel<> wheel;
+  auto const first = wheel.schedule(5U, [&] { calls += 1; });
+  EXPECT_TRUE(wheel.cancel(first));
+
+  // Reuses the entry of the first timer
+  auto const second = wheel.schedule(5U, [&] { calls += 10; });
+  EXPECT_FALSE(wheel.cancel(first));
+  wheel.advance(5U);
+  EXPECT_EQ(calls, 10);
+  EXPECT_FALSE(wheel.cancel(second));
+}
+
+TEST(timer_wheel_tests, are_destroying_cancelled_callbacks)
+{
+  auto const state = std::make_shared<int>(0);
+  fu2::timer_wheel<> wheel;
+  auto const handle = wheel.schedule(100000U, [state] { });
+  EXPECT_EQ(state.use_count(), 2L);
+  wheel.cancel(handle);
+  EXPECT_EQ(state.use_count(), 1L);
+}
+
+TEST(timer_wheel_tests, are_scheduling_from_callbacks)
+{
+  int calls = 0;
+  fu2::timer_wheel<> wheel(1000U);
+  fu2::unique_function<void()> periodic;
+  periodic = [&] {
+    if (++calls < 5)
+      wheel.schedule(100U, [&] { periodic(); });
+  };
+  wheel.schedule(100U, [&] { periodic(); });
+
+  EXPECT_EQ(wheel.advance(1000U), 5UL);
+  EXPECT_EQ(calls, 5);
+  EXPECT_TRUE(wheel.empty());
+}
+
+TEST(timer_wheel_tests, are_storing_move_only_callbacks)
+{
+  int result = 0;
+  auto state = make_unique<int>(7);
+  fu2::timer_wheel<> wheel;
+  wheel.schedule(2U, [&result, state = std::move(state)] { result = *state; });
+  wheel.advance(2U);
+  EXPECT_EQ(result, 7);
+}
+
+TEST(timer_wheel_tests, are_expiring_exactly_across_cascades)
+{
+  std::mt19937_64 random(7U);
+  std::uniform_int_distribution<std::uint64_t> delays(0U, 300000U);
+
+  fu2::timer_wheel<> wheel(12345U);
+  std::vector<fu2::timer_wheel<>::timer> handles;
+  std::size_t mismatches = 0UL;
+  std::size_t expired = 0UL;
+
+  for (std::size_t i = 0UL; i < 2000UL; ++i) {
+    std::uint64_t const delay = delays(random);
+    std::uint64_t const expires = wheel.now() + (delay ? delay : 1U);
+    handles.push_back(wheel.schedule(delay, [&, expires] {
+      ++expired;
+      if (wheel.now() != expires)
+        ++mismatches;
+    }));
+  }
+
+  // Cancels every fourth timer
+  std::size_t cancelled = 0UL;
+  for (std::size_t i = 0UL; i < handles.size(); i += 4UL) {
+    cancelled += wheel.cancel(handles[i]) ? 1UL : 0UL;
+  }
+  EXPECT_EQ(cancelled, 500UL);
+
+  for (std::uint64_t tick = 0U; tick < 300001U; ++tick) {
+    wheel.advance();
+  }
+  EXPECT_EQ(expired, 1500UL);
+  EXPECT_EQ(mismatches, 0UL);
+  EXPECT_TRUE(wheel.empty());
+}
+
+TEST(timer_wheel_tests, are_expiring_beyond_the_last_wheel)
+{
+  int calls = 0;
+  std::uint64_t const far = (std::uint64_t(1) << 36U) + 5U;
+  fu2::timer_wheel<> wheel((std::uint64_t(1) << 36U) - 3U);
+  wheel.schedule(far, [&] { ++calls; });
+
+  wheel.advance(far - 1U);
+  EXPECT_EQ(calls, 0);
+  wheel.advance();
+  EXPECT_EQ(calls, 1);
+}
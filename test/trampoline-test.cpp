@@ -0,0 +1,128 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+#include <array>
+#include <string>
+#include "function2-test.hpp"
+
+extern "C" {
+  /// A C API which invokes a callback with its context
+  typedef int (*c_callback_t)(void*, int);
+
+  struct c_registration {
+    c_callback_t callback;
+    void* context;
+  };
+
+  static void c_register(c_registration* registration,
+                         c_callback_t callback, void* context) {
+    registration->callback = callback;
+    registration->context = context;
+  }
+
+  static int c_emit(c_registration const* registration, int value) {
+    return registration->callback(registration->context, value);
+  }
+}
+
+namespace {
+  /// Functor which accumulates its arguments
+  struct Accumulator {
+    int sum;
+
+    int operator() (int i) {
+      return sum += i;
+    }
+  };
+
+  /// Functor which doesn't fit into the default capacity
+  struct LargeAccumulator {
+    std::array<int, 16> sums;
+
+    int operator() (int i) {
+      return sums[0] += i;
+    }
+  };
+}
+
+ALL_LEFT_TYPED_TEST_CASE(AllTrampolineTests)
+
+TYPED_TEST(AllTrampolineTests, AreInvokingTheTarget)
+{
+  typename TestFixture::template left_t<int(int)> left = Accumulator{1};
+  auto const callback = left.target_trampoline();
+  EXPECT_EQ(callback(2), 3);
+  EXPECT_EQ(callback.invoke(callback.context, 3), 6);
+  EXPECT_EQ(left(4), 10);
+}
+
+TYPED_TEST(AllTrampolineTests, AreInvokingHeapAllocatedTargets)
+{
+  LargeAccumulator accumulator;
+  accumulator.sums[0] = 1;
+  typename TestFixture::template left_t<int(int)> left = accumulator;
+  auto const callback = left.target_trampoline();
+  EXPECT_EQ(callback(2), 3);
+  EXPECT_EQ(left(1), 4);
+}
+
+TYPED_TEST(AllTrampolineTests, AreInvokableThroughCApis)
+{
+  typename TestFixture::template left_t<int(int)> left = Accumulator{0};
+  auto const callback = left.target_trampoline();
+
+  c_registration registration;
+  c_register(&registration, callback.invoke, callback.context);
+  EXPECT_EQ(c_emit(&registration, 5), 5);
+  EXPECT_EQ(c_emit(&registration, 5), 10);
+}
+
+TYPED_TEST(AllTrampolineTests, AreHoistableOutOfLoops)
+{
+  typename TestFixture::template left_t<int(int) const> left =
+    [](int i) { return i * 2; };
+
+  auto const& constant = left;
+  auto const callback = constant.target_trampoline();
+  int sum = 0;
+  for (int i = 0; i < 10; ++i) {
+    sum += callback(i);
+  }
+  EXPECT_EQ(sum, 90);
+}
+
+#ifndef TESTS_NO_EXCEPTIONS
+TYPED_TEST(AllTrampolineTests, AreThrowingIfEmpty)
+{
+  typename TestFixture::template left_t<int(int)> left;
+  auto const callback = left.target_trampoline();
+  EXPECT_THROW(callback(1), fu2::bad_function_call);
+}
+#endif // TESTS_NO_EXCEPTIONS
+
+TEST(trampoline_tests, are_passing_non_scalars_by_reference)
+{
+  fu2::function<std::size_t(std::string)> fn = [](std::string str) {
+    return str.size();
+  };
+
+  fu2::trampoline<std::size_t(std::string)> const callback =
+    fn.target_trampoline();
+  std::string str = "abc";
+  EXPECT_EQ(callback.invoke(callback.context, std::move(str)), 3UL);
+  EXPECT_EQ(callback("ab"), 2UL);
+}
+
+TEST(trampoline_tests, are_surviving_moves_of_compact_functions)
+{
+  fu2::compact_unique_function<int(int)> fn = Accumulator{0};
+  auto const callback = fn.target_trampoline();
+
+  // The target of compact functions isn't moved with the function
+  fu2::compact_unique_function<int(int)> moved = std::move(fn);
+  EXPECT_EQ(callback(2), 2);
+  EXPECT_EQ(moved(1), 3);
+}
@@ -0,0 +1,90 @@
+
+//  Copyright 2015-2016 Denis Blank <denis.blank at outlook dot com>
+//     Distributed under the Boost Software License, Version 1.0
+//       (See accompanying file LICENSE_1_0.txt or copy at
+//             http://www.boost.org/LICENSE_1_0.txt)
+
+#include <array>
+#include "function2-test.hpp"
+
+namespace {
+  /// Functor which counts its invocations
+  struct Counter {
+    int calls;
+
+    int operator() (int i) {
+      return calls += i;
+    }
+  };
+
+  /// Functor which doesn't fit into the default capacity
+  struct LargeCounter {
+    std::array<int, 16> calls;
+
+    int operator() (int i) {
+      return calls[0] += i;
+    }
+  };
+
+  int identity(int i) {
+    return i;
+  }
+}
+
+TEST(type_query_tests, are_identifying_empty_functions_as_void)
+{
+  fu2::function<int(int)> fn;
+  EXPECT_TRUE(fn.target_type_id() == fu2::type_id_of<void>());
+  EXPECT_FALSE(fn.holds<Counter>());
+  EXPECT_EQ(fn.target<Counter>(), nullptr);
+}
+
+TEST(type_query_tests, are_identifying_the_stored_type)
+{
+  fu2::function<int(int)> fn = Counter{0};
+  EXPECT_TRUE(fn.target_type_id() == fu2::type_id_of<Counter>());
+  EXPECT_TRUE(fn.target_type_id() != fu2::type_id_of<LargeCounter>());
+  EXPECT_TRUE(fn.holds<Counter>());
+  EXPECT_FALSE(fn.holds<LargeCounter>());
+
+  fn = identity;
+  EXPECT_TRUE(fn.holds<int(*)(int)>());
+  EXPECT_EQ(*fn.target<int(*)(int)>(), &identity);
+}
+
+TEST(type_query_tests, are_returning_the_target)
+{
+  fu2::function<int(int)> fn = Counter{1};
+  fn(2);
+  ASSERT_NE(fn.target<Counter>(), nullptr);
+  EXPECT_EQ(fn.target<Counter>()->calls, 3);
+  EXPECT_EQ(fn.target<LargeCounter>(), nullptr);
+
+  fu2::function<int(int)> const large = LargeCounter{{{4}}};
+  ASSERT_NE(large.target<LargeCounter>(), nullptr);
+  EXPECT_EQ(large.target<LargeCounter>()->calls[0], 4);
+}
+
+TEST(type_query_tests, are_keeping_the_type_through_moves)
+{
+  fu2::function<int(int)> fn = LargeCounter{{{1}}};
+  fu2::unique_function<int(int)> moved = std::move(fn);
+  EXPECT_TRUE(moved.holds<LargeCounter>());
+
+  fu2::compact_function<int(int)> compact = Counter{2};
+  EXPECT_TRUE(compact.holds<Counter>());
+  EXPECT_EQ(compact.target<Counter>()->calls, 2);
+}
+
+TEST(type_query_tests, are_invocable_as_the_stored_type)
+{
+  fu2::function<int(int)> fn = Counter{0};
+  EXPECT_EQ(fn.invoke_as<Counter>(2), 2);
+  EXPECT_EQ(fn(3), 5);
+
+  fu2::function<int(int)> large = LargeCounter{{{1}}};
+  EXPECT_EQ(large.invoke_as<LargeCounter>(1), 2);
+
+  fu2::function<int(int) const> const constant = identity;
+  EXPECT_EQ(constant.invoke_as<int(*)(int)>(4), 4);
+}